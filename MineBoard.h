@@ -0,0 +1,360 @@
+#pragma once
+
+// Board storage: MineBoardBase holds the board algorithms, DynamicBoard supplies the cells and the geometry of any runtime size
+// Cells are row-major (x = row, y = column) with a one-cell border ring around the board
+// Border cells are stored as BORDER | REVEALED, so neighbor loops over the 8 offsets need no bounds checks
+
+#include <array>
+#include <vector>
+#include <algorithm>
+
+#include "MineCell.h"
+#include "MineNeighborPlane.h"
+#include "MinesweeperRandom.h"
+
+using namespace std;
+
+template <class Board>
+class MineBoardBase {
+    private:
+
+    Board& self ();
+
+    const Board& self () const;
+
+    public:
+
+    bool contains (int x, int y) const;
+    // check if <x,y> is on the board
+
+    int index (int x, int y) const;
+    // index of <x,y> in the padded cells
+
+    int row (int index) const;
+    // row of a padded index
+
+    int column (int index) const;
+    // column of a padded index
+
+    int logicalIndex (int index) const;
+    // border-free row-major index (x * width + y) of a padded index, as used by records
+
+    int paddedIndex (int logical) const;
+    // padded index of a border-free row-major index
+
+    int cellsCount () const;
+    // number of playable cells (width * height)
+
+    CellState& operator[] (int index);
+
+    CellState operator[] (int index) const;
+
+    void clear ();
+    // reset every playable cell and rebuild the border ring
+
+    void computeNeighborBombs ();
+    // compute the neighbor bombs count of every playable cell in one pass
+
+    void placeBombs (int count, const vector <int> &excluded, vector <int> &bombs, MinesweeperRandom &random, vector <uint64_t> &chosen);
+    // place count bombs on a board without bombs in O(count) random draws
+    // excluded are sorted logical indices that never get a bomb, bombs receives the padded indices placed
+    // chosen is a reusable buffer for the bitset of sampled cells
+
+    int floodReveal (int index, vector <int> &queue, int &flagsCleared);
+    // reveal the safe cell at index and the opening around it, returns the number of cells opened
+    // queue is a reusable worklist left holding the opened cells, flagsCleared is increased by the number of flags dropped
+
+    int threeBV (vector <int> &queue, vector <uint8_t> &covered) const;
+    // Bechtel's Board Benchmark Value: the fewest reveals that clear the board
+    // queue and covered are reusable buffers, a worklist and the cells already counted
+
+    static int lowestBit (uint64_t bits);
+    // index of the lowest set bit of a non-zero word
+};
+
+class DynamicBoard : public MineBoardBase <DynamicBoard> {
+    private:
+
+    int boardWidth, boardHeight;
+
+    array <int, 8> neighbors;
+
+    public:
+
+    vector <CellState> cells;
+
+    DynamicBoard (int width = 0, int height = 0);
+    // constructor, creates an empty <width x height> board
+
+    void resize (int width, int height);
+    // resize to an empty <width x height> board
+
+    int width () const;
+
+    int height () const;
+
+    int stride () const;
+
+    const array <int, 8>& neighborOffsets () const;
+
+    CellState* data ();
+
+    const CellState* data () const;
+
+    int paddedSize () const;
+    // number of stored cells, border included
+};
+
+template <class Board>
+Board& MineBoardBase<Board>::self () {
+    return static_cast <Board&>(*this);
+}
+
+template <class Board>
+const Board& MineBoardBase<Board>::self () const {
+    return static_cast <const Board&>(*this);
+}
+
+template <class Board>
+bool MineBoardBase<Board>::contains (int x, int y) const {
+    return x >= 0 && x < self().height() && y >= 0 && y < self().width();
+}
+
+template <class Board>
+int MineBoardBase<Board>::index (int x, int y) const {
+    return (x + 1) * self().stride() + y + 1;
+}
+
+template <class Board>
+int MineBoardBase<Board>::row (int index) const {
+    return index / self().stride() - 1;
+}
+
+template <class Board>
+int MineBoardBase<Board>::column (int index) const {
+    return index % self().stride() - 1;
+}
+
+template <class Board>
+int MineBoardBase<Board>::logicalIndex (int index) const {
+    return row(index) * self().width() + column(index);
+}
+
+template <class Board>
+int MineBoardBase<Board>::paddedIndex (int logical) const {
+    return this->index(logical / self().width(), logical % self().width());
+}
+
+template <class Board>
+int MineBoardBase<Board>::cellsCount () const {
+    return self().width() * self().height();
+}
+
+template <class Board>
+CellState& MineBoardBase<Board>::operator[] (int index) {
+    return self().data()[index];
+}
+
+template <class Board>
+CellState MineBoardBase<Board>::operator[] (int index) const {
+    return self().data()[index];
+}
+
+template <class Board>
+void MineBoardBase<Board>::clear () {
+    CellState* cells = self().data();
+    int stride = self().stride(), height = self().height();
+    fill(cells, cells + self().paddedSize(), MineCell::BORDER | MineCell::REVEALED);
+    for (int x = 0; x < height; ++x) fill(cells + this->index(x, 0), cells + this->index(x, 0) + stride - 2, 0);
+}
+
+template <class Board>
+void MineBoardBase<Board>::computeNeighborBombs () {
+    MineNeighborPlane::compute(self().data() + this->index(0, 0), self().width(), self().height(), self().stride());
+}
+
+template <class Board>
+void MineBoardBase<Board>::placeBombs (int count, const vector <int> &excluded, vector <int> &bombs, MinesweeperRandom &random, vector <uint64_t> &chosen) {
+    // sampling runs over the cells that are not excluded, renumbered 0..cellsCount-1
+    int cellsCount = this->cellsCount() - excluded.size();
+    bombs.clear();
+    if (count <= 0) return;
+    // the chosen set is a bitset (1 bit per cell), much denser in cache than the board itself
+    chosen.assign((cellsCount + 63) / 64, 0);
+    auto isChosen = [&](int index) { return (chosen[index >> 6] >> (index & 63)) & 1; };
+    auto choose = [&](int index) { chosen[index >> 6] |= (uint64_t)1 << (index & 63); };
+    // past half the board, sample the cells that stay free instead
+    bool complement = count > cellsCount / 2;
+    int picks = complement ? cellsCount - count : count;
+    const int bucketBits = 18; // 2^18 cells per bucket, a 32 KB slice of the bitset
+    if (cellsCount > (1 << bucketBits)) {
+        // huge boards: uniform draws, skipping repeats, until picks distinct cells are chosen
+        // each round only counts its draws per bucket, then draws the offsets bucket by bucket
+        // so every membership check stays within one cache-resident slice of the bitset
+        int bucketsCount = ((cellsCount - 1) >> bucketBits) + 1;
+        vector <int> draws(bucketsCount);
+        for (int remaining = picks; remaining > 0;) {
+            fill(draws.begin(), draws.end(), 0);
+            for (int i = 0; i < remaining; ++i) ++draws[random.below(cellsCount) >> bucketBits];
+            for (int bucket = 0; bucket < bucketsCount; ++bucket) {
+                int start = bucket << bucketBits, size = min(1 << bucketBits, cellsCount - start);
+                for (int i = 0; i < draws[bucket]; ++i) {
+                    int index = start + random.below(size);
+                    if (isChosen(index)) continue;
+                    choose(index);
+                    --remaining;
+                }
+            }
+        }
+    }
+    else if ((long long)picks * 8 <= cellsCount) {
+        // sparse: draw random cells and retry on hits, expected draws stay below picks * 8/7
+        for (int picked = 0; picked < picks;) {
+            int index = random.below(cellsCount);
+            if (isChosen(index)) continue;
+            choose(index);
+            ++picked;
+        }
+    }
+    else {
+        // dense: Floyd's sampling, exactly one draw per pick
+        for (int j = cellsCount - picks; j < cellsCount; ++j) {
+            int index = random.below(j + 1);
+            choose(isChosen(index) ? j : index);
+        }
+    }
+    // scatter the bitset into the board, one word at a time, skipping back over the excluded cells
+    CellState* cells = self().data();
+    bombs.reserve(count);
+    size_t skipped = 0;
+    for (size_t word = 0; word < chosen.size(); ++word) {
+        uint64_t bits = complement ? ~chosen[word] : chosen[word];
+        while (bits) {
+            int index = word * 64 + lowestBit(bits);
+            bits &= bits - 1;
+            if (index >= cellsCount) break;
+            while (skipped < excluded.size() && excluded[skipped] <= index + (int)skipped) ++skipped;
+            int padded = paddedIndex(index + skipped);
+            cells[padded] |= MineCell::BOMB;
+            bombs.push_back(padded);
+        }
+    }
+}
+
+template <class Board>
+int MineBoardBase<Board>::floodReveal (int index, vector <int> &queue, int &flagsCleared) {
+    // the revealed bit doubles as the visited bitmap: a cell is marked when it is queued, so it is queued at most once
+    CellState* cells = self().data();
+    const array <int, 8> &offsets = self().neighborOffsets();
+    flagsCleared += MineCell::flagged(cells[index]);
+    cells[index] = (cells[index] | MineCell::REVEALED) & ~MineCell::FLAGGED;
+    queue.clear();
+    queue.push_back(index);
+    // cells are never popped, the queue ends up listing every opened cell for the caller
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int current = queue[head];
+        // if it doesn't have any neighbor bombs, continue expanding it
+        if (MineCell::neighborBombsCount(cells[current]) != 0) continue;
+        for (int offset : offsets) {
+            int neighbor = current + offset;
+            CellState &cell = cells[neighbor];
+            // border cells are revealed, so they stop the fill without a bounds check
+            if (MineCell::revealed(cell) || MineCell::hasBomb(cell)) continue;
+            flagsCleared += MineCell::flagged(cell);
+            cell = (cell | MineCell::REVEALED) & ~MineCell::FLAGGED;
+            queue.push_back(neighbor);
+        }
+    }
+    return queue.size();
+}
+
+template <class Board>
+int MineBoardBase<Board>::threeBV (vector <int> &queue, vector <uint8_t> &covered) const {
+    const CellState* cells = self().data();
+    const array <int, 8> &offsets = self().neighborOffsets();
+    int width = self().width(), height = self().height(), value = 0;
+    // border cells count as covered, so the fill needs no bounds check
+    covered.assign(self().paddedSize(), 1);
+    for (int x = 0; x < height; ++x) fill(covered.begin() + this->index(x, 0), covered.begin() + this->index(x, 0) + width, 0);
+    auto opening = [&](int index) { return !MineCell::hasBomb(cells[index]) && MineCell::neighborBombsCount(cells[index]) == 0; };
+    // one reveal per opening, it clears the opening and the numbers around it
+    for (int x = 0; x < height; ++x) {
+        for (int index = this->index(x, 0), end = index + width; index < end; ++index) {
+            if (covered[index] || !opening(index)) continue;
+            ++value;
+            covered[index] = 1;
+            queue.clear();
+            queue.push_back(index);
+            while (!queue.empty()) {
+                int current = queue.back();
+                queue.pop_back();
+                for (int offset : offsets) {
+                    int neighbor = current + offset;
+                    if (covered[neighbor]) continue;
+                    covered[neighbor] = 1;
+                    if (opening(neighbor)) queue.push_back(neighbor);
+                }
+            }
+        }
+    }
+    // one reveal for every other safe cell
+    for (int x = 0; x < height; ++x) {
+        for (int index = this->index(x, 0), end = index + width; index < end; ++index) value += !covered[index] && !MineCell::hasBomb(cells[index]);
+    }
+    return value;
+}
+
+template <class Board>
+int MineBoardBase<Board>::lowestBit (uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(bits);
+#else
+    int index = 0;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+DynamicBoard::DynamicBoard (int width, int height) {
+    resize(width, height);
+}
+
+void DynamicBoard::resize (int width, int height) {
+    boardWidth = max(width, 0);
+    boardHeight = max(height, 0);
+    int s = stride();
+    neighbors = {-s - 1, -s, -s + 1, -1, 1, s - 1, s, s + 1};
+    cells.assign((size_t)(boardWidth + 2) * (boardHeight + 2), 0);
+    clear();
+}
+
+int DynamicBoard::width () const {
+    return boardWidth;
+}
+
+int DynamicBoard::height () const {
+    return boardHeight;
+}
+
+int DynamicBoard::stride () const {
+    return boardWidth + 2;
+}
+
+const array <int, 8>& DynamicBoard::neighborOffsets () const {
+    return neighbors;
+}
+
+CellState* DynamicBoard::data () {
+    return cells.data();
+}
+
+const CellState* DynamicBoard::data () const {
+    return cells.data();
+}
+
+int DynamicBoard::paddedSize () const {
+    return cells.size();
+}
\ No newline at end of file
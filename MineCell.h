@@ -1,18 +1,81 @@
+#pragma once
 
+#include <array>
+#include <cstdint>
+
+// Packed state of one cell, stored as a single byte in MineField's board array
+// bit 0: bomb, bit 1: revealed, bit 2: flagged, bit 3: board border, bits 4-7: neighbor bombs count
+
+typedef uint8_t CellState;
 
 class MineCell {
     public:
 
-    MineCell (int xPos, int yPos, bool cellHasBomb) {
-        x=xPos;
-        y=yPos;
-        hasBomb=(bool)cellHasBomb;
-        revealed = false;
-        neighborBombsCount = 0;
-        flagged = false;
-    };
+    static const CellState BOMB = 1;
+
+    static const CellState REVEALED = 2;
+
+    static const CellState FLAGGED = 4;
+
+    static const CellState BORDER = 8; // padding ring around the board, always stored together with REVEALED
+
+    static const CellState STATE_MASK = 7; // bits written to records (flagged*4 + revealed*2 + hasBomb)
+
+    static const CellState COUNT_MASK = 0xF0;
+
+    static const int COUNT_SHIFT = 4;
+
+    static bool hasBomb (CellState cell);
+    // check if the cell has a bomb
+
+    static bool revealed (CellState cell);
+    // check if the cell is revealed
+
+    static bool flagged (CellState cell);
+    // check if the cell is flagged
+
+    static int neighborBombsCount (CellState cell);
+    // get the stored neighbor bombs count
+
+    static CellState withNeighborBombsCount (CellState cell, int count);
+    // return the cell with its neighbor bombs count replaced
+
+    static char glyph (CellState cell);
+    // character drawn for the cell, looked up in a table precomputed for every cell byte
+};
+
+bool MineCell::hasBomb (CellState cell) {
+    return cell & BOMB;
+}
+
+bool MineCell::revealed (CellState cell) {
+    return cell & REVEALED;
+}
+
+bool MineCell::flagged (CellState cell) {
+    return cell & FLAGGED;
+}
+
+int MineCell::neighborBombsCount (CellState cell) {
+    return cell >> COUNT_SHIFT;
+}
 
-    int x, y, neighborBombsCount;
+CellState MineCell::withNeighborBombsCount (CellState cell, int count) {
+    return (CellState)((cell & ~COUNT_MASK) | (count << COUNT_SHIFT));
+}
 
-    bool hasBomb, revealed, flagged;
-};
\ No newline at end of file
+char MineCell::glyph (CellState cell) {
+    static const std::array <char, 256> table = [] {
+        std::array <char, 256> glyphs;
+        for (int value = 0; value < 256; ++value) {
+            CellState state = (CellState)value;
+            if (revealed(state)) {
+                if (hasBomb(state)) glyphs[value] = flagged(state) ? 'X' : '*';
+                else glyphs[value] = neighborBombsCount(state) == 0 ? ' ' : (char)('0' + neighborBombsCount(state));
+            }
+            else glyphs[value] = flagged(state) ? 'F' : '-';
+        }
+        return glyphs;
+    }();
+    return table[cell];
+}
\ No newline at end of file
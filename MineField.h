@@ -1,9 +1,15 @@
+#pragma once
+
+#include <cassert>
+#include <chrono>
 #include <cmath>
 #include <iostream>
 #include <ctime>
 #include <string>
 
-#include "MineCell.h"
+#include "MineBoard.h"
+#include "MinesweeperFrame.h"
+#include "MinesweeperMoveLog.h"
 #include "MinesweeperUtils.h"
 
 using namespace std;
@@ -11,136 +17,250 @@ using namespace std;
 class MineField {
     private:
 
-    vector <MineCell*> flatMap; // flatMap data
-
     MinesweeperUtils Utils;
 
-    vector <MineCell*> bombs; // bombs data
+    vector <int> bombs; // board indices of cells with bombs
+
+    vector <int> revealQueue; // worklist reused by floodReveal
+
+    vector <int> safeZone; // logical indices kept free of bombs, reused by generateBombs
+
+    vector <uint64_t> chosenCells; // bitset reused by placeBombs
+
+    vector <uint8_t> coveredCells; // cells already counted, reused by threeBV
+
+    int64_t lastMoveTime; // steady clock milliseconds of the last move, or of the (re)opening of the field
+
+    void openCell (int index);
+    // mark the cell revealed, dropping its flag and keeping flagsCount in sync
+
+    void logMove (int x, int y, bool flag);
+    // append the move to moves, timed from the previous one
 
     public:
 
     bool valid; // if the field is valid or not
     
-    int Size; // Size of the field
+    int Width; // number of columns
 
-    int unrevealedCellsCount; // number of unrevealed cells
+    int Height; // number of rows
+
+    int unrevealedCellsCount; // number of unrevealed cells, kept up to date by every mutation
 
     int bombsCount; // Number of bombs
 
-    int flagsCount; // number of flags
+    int flagsCount; // number of flags left (bombs count - flagged cells), kept up to date by every mutation
+
+    bool firstTime; // first click or not, bombs are (re)generated on the first click
 
-    bool firstTime; // first click or not
+    bool safeOpening; // keep the 3x3 zone around the first click free of bombs, not just the clicked cell
 
     long savedTimestamp; // saved timestamp
 
     long timesPlayed; // times played
 
+    uint64_t recordId; // id of the field in the records journal, 0 if it was never saved
+
+    static const int GENERATOR_VERSION = 1; // bump whenever generateBombs would place other bombs for the same seed and click
+
+    uint64_t seed; // seed of the bombs generator, the whole layout follows from it and the first click
+
+    bool seeded; // the bombs came (or will come) from seed, so a record can store seed and firstClick instead of the layout
+
+    int firstClick; // logical index (x * Width + y) of the first reveal, -1 before it
+
+    MinesweeperMoveLog moves; // every reveal and flag that changed the field, in order
+
+    bool logMoves; // append the moves to moves, a replay turns it off
+
+    vector <int> changedCells; // board indices of the cells revealed, flagged or unflagged while logChanges is set
+
+    bool logChanges; // append to changedCells, a solver following the field turns it on and drains it
+
     int openedTimestamp; // timestamp when you reopen the record
 
-    vector <vector <MineCell*>> map; // Map data
+    DynamicBoard board; // Map data, one packed byte per cell
+
+    MineField (int FieldHeight, int FieldWidth, int BombsCount, bool SafeOpening = true);
+    // constructor for creating new MineField, bombs are placed on the first reveal
+
+    MineField (long Timestamp, long TimesPlayed, int FieldHeight, int FieldWidth);
+    // constructor for a saved MineField: the board starts empty, a record reader fills it and calls restore
 
-    MineField (int FieldSize, int BombsCount);
-    // constructor for creating new MineField
+    MineField* snapshot () const;
+    // copy of what a record needs: the packed board, the metadata and the move log
+    // the scratch buffers and the bombs list are left empty, the snapshot is only written, never played
 
-    MineField (long Timestamp, long TimesPlayed, int FieldSize, string data);
-    // constructor for creating new MineField based on data
+    bool restore (int expectedBombs = -1);
+    // rebuild the bombs list and the counters from the board cells, returns valid
+    // expectedBombs, if not -1, must match the bombs on the board; an untouched board without bombs gets that many on its first reveal
 
     void initMap();
-    // setup the map
+    // setup the map before playing it
+
+    void reset (uint64_t Seed);
+    // restart as a new untouched field of the same size and bombs, generated from Seed, reusing every buffer
 
     bool reveal (int x, int y, bool passiveMode, bool flagged);
     // Reveal the cell at (x,y) <Array position>, returns `true` if the cell has bomb, `false` otherwise
 
-    void createEmptyMap (int mapSize);
-    // Create a blank Map from given Map Size
+    bool chord (int x, int y);
+    // reveal the unflagged neighbors of the revealed number at (x,y) once as many flags surround it, `true` if one has a bomb
+
+    int floodReveal (int index);
+    // reveal the safe cell at index and the opening around it, returns the number of cells opened
+
+    void createEmptyMap (int mapHeight, int mapWidth);
+    // Create a blank Map from given Map dimensions
 
-    string createHBorder(string start, string end);
-    // create horizontal borders with specific starting and ending character sequences
+    int cellIndex (int x, int y) const;
+    // return the index of <x,y> in the board
 
-    int safeIndex (int index);
-    // return safe index based on field size
+    void appendHBorder (MinesweeperFrame &frame, int columns, const char* start, const char* end) const;
+    // append a horizontal border with specific starting and ending character sequences
 
-    void flattenMap();
-    // flatten 2D vector to 1D vector assigned in this->flatMap
+    void generateBombs (int x, int y);
+    // (re)place all bombs, keeping <x,y> (and its neighbors in safeOpening mode) free
 
-    bool assignRandomBomb();
-    // assign a bomb to random position, return false if failed
+    void placeBombs (int count, const vector <int> &excluded);
+    // place count bombs on an empty map in O(count) random draws from seed, never on the sorted excluded logical indices
 
-    void render ();
-    // Render the map to the console
+    uint64_t bombsDigest () const;
+    // digest of the bomb layout read from the board, to check that a regenerated board is identical, O(board)
 
-    void getAllBombs();
-    // get All Bombs in current map
+    void render (MinesweeperFrame &frame, const MinesweeperColors &colors) const;
+    // Render the map and the status line into frame, the caller flushes it
+
+    void render (MinesweeperFrame &frame, const MinesweeperColors &colors, int top, int left, int rows, int columns) const;
+    // Render the window of <rows x columns> cells starting at <top,left> and the status line into frame
+
+    void renderStatus (MinesweeperFrame &frame) const;
+    // Render the status line (size, bombs, flags) into frame, without the line break
 
     void revealAllBombs();
     // reveal all bombs in the map
 
-    string exportData();
-    // save export the map to file-readable string
-
     void save();
     // save the timestamp
 
     void flag(int x, int y);
     // flag the specified cell
 
-    void getAllFlags();
-    // get all current flags in the field
+    bool checkConsistency ();
+    // recount the whole field and compare with the incremental counters, O(board), for debugging
 
-    void getNeighborBombs (int x, int y);
-    // get neighbor bombs at <x,y>
+    void computeNeighborBombs ();
+    // compute the neighbor bombs count of every cell in one pass
+
+    int threeBV ();
+    // the fewest reveals that clear the field (3BV), 0 before the bombs are placed
+
+    uint64_t playTime () const;
+    // milliseconds from the first reveal to the last move, whole seconds of timesPlayed if the move log is not complete
 };
 
-MineField::MineField (int FieldSize, int BombsCount) {
+MineField::MineField (int FieldHeight, int FieldWidth, int BombsCount, bool SafeOpening) {
     savedTimestamp = time(0);
     timesPlayed = 0;
-    Size = FieldSize;
-    bombsCount = BombsCount < (pow(Size, 2) - 1) ? BombsCount : (pow(Size, 2) - 1);
-    createEmptyMap(Size);
-    flattenMap();
-    for (int i = 0; i < bombsCount; ++i) assignRandomBomb();
+    recordId = 0;
+    seed = Utils.randomEngine()();
+    seeded = true;
+    firstClick = -1;
+    moves.clear(true);
+    logMoves = true;
+    logChanges = false;
+    Height = FieldHeight;
+    Width = FieldWidth;
+    bombsCount = min(BombsCount, Height * Width - 1);
+    createEmptyMap(Height, Width);
     valid = true;
     firstTime = true;
+    safeOpening = SafeOpening;
+    unrevealedCellsCount = board.cellsCount();
+    flagsCount = bombsCount;
     initMap();
 };
 
-MineField::MineField (long Timestamp, long TimesPlayed, int FieldSize, string data) {
+MineField::MineField (long Timestamp, long TimesPlayed, int FieldHeight, int FieldWidth) {
     savedTimestamp = Timestamp;
     timesPlayed = max(TimesPlayed, 0l);
-    Size = max(FieldSize, 3);
-    createEmptyMap(Size);
-    valid = true;
+    recordId = 0;
+    seed = 0;
+    seeded = false;
+    firstClick = -1;
+    moves.clear(true);
+    logMoves = true;
+    logChanges = false;
+    Height = max(FieldHeight, 1);
+    Width = max(FieldWidth, 1);
+    createEmptyMap(Height, Width);
+    valid = false;
+    firstTime = true;
+    safeOpening = true;
+    bombsCount = flagsCount = 0;
+    unrevealedCellsCount = board.cellsCount();
+}
+
+MineField* MineField::snapshot () const {
+    // the empty board the constructor makes stays 1x1, the packed board is then copied once
+    MineField* copy = new MineField(savedTimestamp, timesPlayed, 1, 1);
+    copy->board = board;
+    copy->Height = Height;
+    copy->Width = Width;
+    copy->valid = valid;
+    copy->unrevealedCellsCount = unrevealedCellsCount;
+    copy->bombsCount = bombsCount;
+    copy->flagsCount = flagsCount;
+    copy->firstTime = firstTime;
+    copy->safeOpening = safeOpening;
+    copy->recordId = recordId;
+    copy->seed = seed;
+    copy->seeded = seeded;
+    copy->firstClick = firstClick;
+    copy->moves = moves;
+    copy->logMoves = false;
+    copy->openedTimestamp = openedTimestamp;
+    return copy;
+}
+
+bool MineField::restore (int expectedBombs) {
+    valid = false;
     firstTime = true;
-    for (vector <MineCell*> row : map) {
-        for (MineCell* cell : row) {
-            if (data.length() == 0) goto nextProcess;
-            int ut = Utils.stoi(data.substr(0,1)); 
-            data = data.substr(1, data.length());
-            cell->hasBomb = (bool)(ut % 2);
-            ut /= 2;
-            cell->revealed = (bool)(ut % 2);
-            ut /= 2;
-            cell->flagged = (bool)(ut % 2);
-            if (cell->revealed) firstTime = false;
-            if (cell->hasBomb && cell->revealed) {
-                valid = false;
-                return;
+    bombs.clear();
+    changedCells.clear();
+    unrevealedCellsCount = board.cellsCount();
+    int flaggedCount = 0;
+    for (int x = 0; x < Height; ++x) {
+        for (int y = 0; y < Width; ++y) {
+            int i = cellIndex(x, y);
+            CellState &cell = board[i];
+            cell &= MineCell::STATE_MASK;
+            if (MineCell::revealed(cell)) {
+                // a revealed bomb is a lost game, it can't be resumed
+                if (MineCell::hasBomb(cell)) return false;
+                firstTime = false;
+                --unrevealedCellsCount;
             }
+            if (MineCell::hasBomb(cell)) bombs.push_back(i);
+            flaggedCount += MineCell::flagged(cell);
         }
     }
-    nextProcess: flattenMap();
-    getAllBombs();
     bombsCount = bombs.size();
-    if (bombsCount == 0) {
-        valid = false;
-        return;
-    }
-    for (vector <MineCell*> row : map) {
-        for (MineCell* cell : row) {
-            if (cell->revealed && !cell->hasBomb) getNeighborBombs(cell->x, cell->y);
-        }
-    }
+    // an untouched field may be stored without its bombs, they are generated on the first reveal anyway
+    if (bombsCount == 0 && firstTime && expectedBombs > 0 && expectedBombs < board.cellsCount()) bombsCount = expectedBombs;
+    if (bombsCount == 0 || (expectedBombs != -1 && bombsCount != expectedBombs)) return false;
+    // the first reveal of an untouched field generates its bombs again, whatever was stored, so it needs a seed of its own
+    // a revealed field keeps the bombs stored cell by cell, they can't be told from a seed
+    seeded = firstTime;
+    if (seeded) seed = Utils.randomEngine()();
+    firstClick = -1;
+    // the moves that led here are unknown, a replay can't start from the empty board
+    moves.clear(firstTime && flaggedCount == 0);
+    flagsCount = bombsCount - flaggedCount;
+    computeNeighborBombs();
     initMap();
+    valid = true;
+    return true;
 }
 
 void MineField::save() {
@@ -150,176 +270,251 @@ void MineField::save() {
     savedTimestamp = currentTime;
 }
 
-string MineField::exportData() {
-    string exp = to_string(savedTimestamp) + "\n" + to_string(timesPlayed) + "\n" + to_string(Size) + "\n";
-    for (vector<MineCell*> row : map) {
-        for (MineCell* cell : row) exp += to_string(cell->flagged * 4 + cell->revealed * 2 + cell->hasBomb);
-    }
-    return exp;
+void MineField::reset (uint64_t Seed) {
+    board.clear();
+    bombs.clear();
+    savedTimestamp = time(0);
+    timesPlayed = 0;
+    recordId = 0;
+    seed = Seed;
+    seeded = true;
+    firstClick = -1;
+    moves.clear(true);
+    changedCells.clear();
+    valid = true;
+    firstTime = true;
+    unrevealedCellsCount = board.cellsCount();
+    flagsCount = bombsCount;
+    initMap();
 }
 
 void MineField::initMap () {
     openedTimestamp = time(0);
-    unrevealedCellsCount = 0;
-    getAllFlags();
-    for (vector <MineCell*> row : map) {
-        for (MineCell* cell : row) {
-            unrevealedCellsCount += !cell->revealed;
-        }
-    }
+    lastMoveTime = chrono::duration_cast <chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#ifdef MINESWEEPER_DEBUG
+    assert(checkConsistency());
+#endif
 }
 
-int MineField::safeIndex (int index) {
-    return min(max(index, 0), Size - 1);
-};
-
 bool MineField::reveal (int x, int y, bool passiveMode, bool flagged) {
-    if ((x < 0 || x >= Size) || (y < 0 || y >= Size)) return false;
+    if (!board.contains(x, y)) return false;
     if (flagged) {
         flag(x, y);
         return false;
     }
-    MineCell* revealingCell = map[x][y];
-    if (revealingCell->revealed || (!passiveMode && revealingCell->flagged)) return false;
-    int firstReveal = firstTime;
-    if (revealingCell->hasBomb) {
-        if (passiveMode) return true;
-        if (firstTime) {
-            // first reveal can't be bombed, right?
-            revealingCell->hasBomb = false;
-            // eject this position from free slot <flatMap> data
-            for (int i = 0; i < flatMap.size(); ++i) {
-                MineCell* cell = flatMap[i];
-                if (cell->x == x && cell->y == y) {
-                    flatMap.erase(flatMap.begin() + i);
-                    break;
-                }
-            }
-            // assign bombs to another location
-            assignRandomBomb();
-        }
-    }
-    firstTime = false;
-    if (firstReveal) {
-        getAllBombs();
+    int index = cellIndex(x, y);
+    CellState &revealingCell = board[index];
+    if (MineCell::revealed(revealingCell) || (!passiveMode && MineCell::flagged(revealingCell))) return false;
+    // the log replays player moves, a passive reveal can't be told from one
+    if (passiveMode) moves.clear(false);
+    else logMove(x, y, false);
+    if (firstTime) {
+        // first reveal can't be bombed, right? the bombs are only placed now, around the clicked cell
+        generateBombs(x, y);
+        firstTime = false;
         save();
         timesPlayed = 0;
     }
-    revealingCell->revealed = true;
-    revealingCell->flagged = false;
-    getAllFlags();
-    --unrevealedCellsCount;
-    if (revealingCell->hasBomb) return true;
-    // check neigbor bombs
-    getNeighborBombs(x, y);
-    // if it doesn't have any neighbor bombs, continue expanding it
-    if (revealingCell->neighborBombsCount == 0) {
-        for (int i = safeIndex(x - 1); i <= safeIndex(x + 1); ++i) {
-            for (int j = safeIndex(y - 1); j <= safeIndex(y + 1); ++j) {
-                reveal(i, j, true, false);
-            }
-        }
+    if (MineCell::hasBomb(revealingCell)) {
+        if (passiveMode) return true;
+        openCell(index);
+        if (logChanges) changedCells.push_back(index);
+        --unrevealedCellsCount;
+        return true;
     }
+    unrevealedCellsCount -= floodReveal(index);
+#ifdef MINESWEEPER_DEBUG
+    assert(checkConsistency());
+#endif
     return false;
 };
 
-void MineField::createEmptyMap (int mapSize) {
-    map.clear();
-    for (int i = 0; i < mapSize; ++i) {
-        map.push_back(vector<MineCell*>());
-        for (int j = 0; j < mapSize; ++j) map[i].push_back(new MineCell(i,j,false));   
+bool MineField::chord (int x, int y) {
+    if (!board.contains(x, y)) return false;
+    int index = cellIndex(x, y);
+    CellState cell = board[index];
+    if (!MineCell::revealed(cell) || MineCell::neighborBombsCount(cell) == 0) return false;
+    int flags = 0;
+    for (int offset : board.neighborOffsets()) flags += MineCell::flagged(board[index + offset]);
+    if (flags != MineCell::neighborBombsCount(cell)) return false;
+    // one reveal per neighbor, so the move log replays a chord like the reveals it made
+    bool hasBomb = false;
+    for (int i = x - 1; i <= x + 1; ++i) {
+        for (int j = y - 1; j <= y + 1; ++j) {
+            if (i != x || j != y) hasBomb |= reveal(i, j, false, false);
+        }
     }
+    return hasBomb;
+}
+
+int MineField::floodReveal (int index) {
+    int flagsCleared = 0;
+    int opened = board.floodReveal(index, revealQueue, flagsCleared);
+    flagsCount += flagsCleared;
+    if (logChanges) changedCells.insert(changedCells.end(), revealQueue.begin(), revealQueue.end());
+    return opened;
+}
+
+void MineField::createEmptyMap (int mapHeight, int mapWidth) {
+    board.resize(mapWidth, mapHeight);
 };
 
-string MineField::createHBorder(string start, string end) {
-    string hBorder = "";
-    for (int i = 0; i <= (Size-1)*2; ++i) hBorder += "-";
-    hBorder = start + hBorder + end + "\n";
-    return hBorder;
+int MineField::cellIndex (int x, int y) const {
+    return board.index(x, y);
 }
 
-void MineField::render () {
-    string hBorder = createHBorder("|", "|");
-    cout << createHBorder("┌", "┐");
-    for (int i = 0; i < Size; ++i) {
-        vector <MineCell*> row = map[i];
-        if (i > 0) cout << hBorder;
-        for (MineCell* cell : row) {
-            cout << "|";
-            if (cell->revealed) {
-                if (cell->hasBomb) {
-                    if (cell->flagged )cout << "X";
-                    else cout << "*";
-                }
-                else {
-                    if (cell->neighborBombsCount == 0) cout << " ";
-                    else cout << cell->neighborBombsCount;
-                }
-            }
-            else {
-                if (cell->flagged) cout << "F";
-                else cout << "-";
-            }
+void MineField::appendHBorder (MinesweeperFrame &frame, int columns, const char* start, const char* end) const {
+    frame.append(start);
+    frame.appendRepeat('-', (columns - 1) * 2 + 1);
+    frame.append(end);
+    frame.append('\n');
+}
+
+void MineField::render (MinesweeperFrame &frame, const MinesweeperColors &colors) const {
+    render(frame, colors, 0, 0, Height, Width);
+}
+
+void MineField::render (MinesweeperFrame &frame, const MinesweeperColors &colors, int top, int left, int rows, int columns) const {
+    appendHBorder(frame, columns, "┌", "┐");
+    for (int i = top; i < top + rows; ++i) {
+        if (i > top) appendHBorder(frame, columns, "|", "|");
+        const CellState* row = board.data() + cellIndex(i, 0);
+        for (int j = left; j < left + columns; ++j) {
+            colors.append(frame, '|', MinesweeperColors::DEFAULT);
+            colors.appendCell(frame, row[j]);
         }
-        cout << "|" << endl;
+        colors.append(frame, '|', MinesweeperColors::DEFAULT);
+        frame.append('\n');
     }
-    cout << createHBorder("└", "┘") << "Field size: " << Size << " | " << "Bombs: " << bombsCount << " | " << "Flags: " << flagsCount << endl;
+    appendHBorder(frame, columns, "└", "┘");
+    renderStatus(frame);
+    frame.append('\n');
 }
 
-void MineField::flattenMap () {
-    flatMap.clear();
-    for (vector <MineCell*> row : map) {
-        for (MineCell* cell: row) {
-            if (!cell->hasBomb) flatMap.push_back(cell);
+void MineField::renderStatus (MinesweeperFrame &frame) const {
+    frame.append("Field size: ");
+    frame.appendInt(Height);
+    frame.append('x');
+    frame.appendInt(Width);
+    frame.append(" | Bombs: ");
+    frame.appendInt(bombsCount);
+    frame.append(" | Flags: ");
+    frame.appendInt(flagsCount);
+}
+
+void MineField::generateBombs (int x, int y) {
+    for (int index : bombs) board[index] &= ~MineCell::BOMB;
+    safeZone.clear();
+    firstClick = board.contains(x, y) ? x * Width + y : -1;
+    if (board.contains(x, y)) {
+        // the 3x3 zone only fits if enough cells remain for all the bombs
+        bool wholeZone = safeOpening && board.cellsCount() - 9 >= bombsCount;
+        for (int i = x - 1; i <= x + 1; ++i) {
+            for (int j = y - 1; j <= y + 1; ++j) {
+                if (board.contains(i, j) && (wholeZone || (i == x && j == y))) safeZone.push_back(i * Width + j);
+            }
         }
     }
+    placeBombs(bombsCount, safeZone);
+    computeNeighborBombs();
 }
 
-bool MineField::assignRandomBomb () {
-    if (flatMap.size() == 0) return false;
-    int index = Utils.randInt(flatMap.size() - 1);
-    MineCell* randomCell = flatMap[index];
-    flatMap.erase(flatMap.begin() + index);
-    return randomCell->hasBomb = true;
+void MineField::placeBombs (int count, const vector <int> &excluded) {
+    // a fresh engine per generation, the same seed and first click always give the same bombs
+    MinesweeperRandom random(seed);
+    board.placeBombs(count, excluded, bombs, random, chosenCells);
 }
 
-void MineField::getAllBombs() {
-    bombs.clear();
-    for (vector <MineCell*> row : map) {
-        for (MineCell* cell: row) {
-            if (cell->hasBomb) bombs.push_back(cell);
+uint64_t MineField::bombsDigest () const {
+    // count plus the sum of the mixed logical indices, the board is read rather than the bombs list, which a snapshot has not
+    uint64_t digest = 0, logical = 0;
+    for (int x = 0; x < Height; ++x) {
+        const CellState* row = board.data() + cellIndex(x, 0);
+        for (int y = 0; y < Width; ++y, ++logical) {
+            if (!MineCell::hasBomb(row[y])) continue;
+            uint64_t z = logical + 0x9E3779B97F4A7C15ull;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            digest += 1 + (z ^ (z >> 31));
         }
     }
+    return digest;
 }
 
 void MineField::revealAllBombs () {
-    for (MineCell* cell : bombs) {
-        cell->revealed = true;
+    for (int index : bombs) {
+        if (MineCell::revealed(board[index])) continue;
+        board[index] |= MineCell::REVEALED;
+        --unrevealedCellsCount;
+        if (logChanges) changedCells.push_back(index);
     }
 }
 
 void MineField::flag (int x, int y) {
-    if ((x < 0 || x >= Size) || (y < 0 || y >= Size)) return;
-    MineCell* revealingCell = map[x][y];
-    if (revealingCell->revealed) return;
-    revealingCell->flagged = !revealingCell->flagged;
-    getAllFlags();
+    if (!board.contains(x, y)) return;
+    CellState &revealingCell = board[cellIndex(x, y)];
+    if (MineCell::revealed(revealingCell)) return;
+    logMove(x, y, true);
+    revealingCell ^= MineCell::FLAGGED;
+    if (logChanges) changedCells.push_back(cellIndex(x, y));
+    flagsCount += MineCell::flagged(revealingCell) ? -1 : 1;
+#ifdef MINESWEEPER_DEBUG
+    assert(checkConsistency());
+#endif
 }
 
-void MineField::getAllFlags () {
-    flagsCount = bombsCount;
-    for (vector <MineCell*> row : map) {
-        for (MineCell* cell: row) flagsCount -= cell->flagged;
-    }
+void MineField::logMove (int x, int y, bool flag) {
+    if (!logMoves) return;
+    int64_t now = chrono::duration_cast <chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    moves.append(x * Width + y, flag, (uint32_t)min <int64_t>(max <int64_t>(now - lastMoveTime, 0), UINT32_MAX));
+    lastMoveTime = now;
+}
+
+void MineField::openCell (int index) {
+    CellState &cell = board[index];
+    if (MineCell::flagged(cell)) ++flagsCount;
+    cell = (cell | MineCell::REVEALED) & ~MineCell::FLAGGED;
 }
 
-void MineField::getNeighborBombs (int x, int y) {
-    MineCell* cell = map[x][y];
-    cell->neighborBombsCount = 0;
-    if ((x < 0 || x >= Size) || (y < 0 || y >= Size)) return;
-    for (int i = safeIndex(x - 1); i <= safeIndex(x + 1); ++i) {
-        for (int j = safeIndex(y - 1); j <= safeIndex(y + 1); ++j) {
-            cell->neighborBombsCount += map[i][j]->hasBomb;
+bool MineField::checkConsistency () {
+    int unrevealed = 0, flagged = 0;
+    size_t bombsFound = 0;
+    for (int x = 0; x < Height; ++x) {
+        for (int y = 0; y < Width; ++y) {
+            CellState cell = board[cellIndex(x, y)];
+            unrevealed += !MineCell::revealed(cell);
+            flagged += MineCell::flagged(cell);
+            bombsFound += MineCell::hasBomb(cell);
         }
     }
+    if (unrevealed != unrevealedCellsCount || bombsCount - flagged != flagsCount) return false;
+    // bombs only exist once they are placed, and then the index must list exactly them
+    if (bombsFound != bombs.size()) return false;
+    for (int index : bombs) {
+        if (!MineCell::hasBomb(board[index])) return false;
+    }
+    return bombs.empty() || bombs.size() == static_cast<size_t>(bombsCount);
+}
+
+void MineField::computeNeighborBombs () {
+    board.computeNeighborBombs();
+}
+
+int MineField::threeBV () {
+    if (firstTime) return 0;
+    return board.threeBV(revealQueue, coveredCells);
+}
+
+uint64_t MineField::playTime () const {
+    if (!moves.complete) return (uint64_t)timesPlayed * 1000;
+    // the clock starts with the first reveal, like the classic timer, flags placed before it are free
+    uint64_t total = 0;
+    bool started = false;
+    size_t cursor = 0;
+    MinesweeperMove move;
+    for (uint32_t i = 0; i < moves.count && moves.next(cursor, move); ++i) {
+        if (started) total += move.delay;
+        if (!move.flag) started = true;
+    }
+    return total;
 }
\ No newline at end of file
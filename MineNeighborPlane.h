@@ -0,0 +1,115 @@
+#pragma once
+
+// Whole-board neighbor bombs counting as a separable 3x3 box sum over the bomb bitplane
+// Rows are processed with SSE2/AVX2 when the compiler targets them, with a scalar fallback
+
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "MineCell.h"
+
+using namespace std;
+
+class MineNeighborPlane {
+    public:
+
+    static void compute (CellState* cells, int width, int height, int stride);
+    // store the neighbor bombs count of every cell in a <width x height> row-major board, rows stride cells apart
+
+    static void extractBombs (uint8_t* out, const CellState* cells, int n);
+    // out[i] = 1 if cells[i] has a bomb, 0 otherwise
+
+    static void sumRows (uint8_t* out, const uint8_t* a, const uint8_t* b, const uint8_t* c, int n);
+    // out[i] = a[i] + b[i] + c[i]
+
+    static void packCounts (CellState* cells, const uint8_t* sums, const uint8_t* bombs, int n);
+    // write (sums[i] - bombs[i]) into the count bits of cells[i], keeping the other bits
+};
+
+void MineNeighborPlane::compute (CellState* cells, int width, int height, int stride) {
+    if (width <= 0 || height <= 0) return;
+    // bomb rows are padded with a zero on each side so the horizontal sum needs no edge cases
+    vector <uint8_t> bombRows(3 * (width + 2), 0), hSums(3 * width, 0), zeros(width, 0), sums(width);
+    auto bombRow = [&](int row) { return &bombRows[(row % 3) * (width + 2)]; };
+    auto hSum = [&](int row) { return &hSums[(row % 3) * width]; };
+    auto loadRow = [&](int row) {
+        uint8_t* b = bombRow(row);
+        extractBombs(b + 1, cells + (size_t)row * stride, width);
+        sumRows(hSum(row), b, b + 1, b + 2, width);
+    };
+    loadRow(0);
+    for (int row = 0; row < height; ++row) {
+        if (row + 1 < height) loadRow(row + 1);
+        const uint8_t* above = row > 0 ? hSum(row - 1) : zeros.data();
+        const uint8_t* below = row + 1 < height ? hSum(row + 1) : zeros.data();
+        sumRows(sums.data(), above, hSum(row), below, width);
+        packCounts(cells + (size_t)row * stride, sums.data(), bombRow(row) + 1, width);
+    }
+}
+
+void MineNeighborPlane::extractBombs (uint8_t* out, const CellState* cells, int n) {
+    int i = 0;
+#if defined(__AVX2__)
+    const __m256i mask = _mm256_set1_epi8(MineCell::BOMB);
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(cells + i));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_and_si256(v, mask));
+    }
+#elif defined(__SSE2__)
+    const __m128i mask = _mm_set1_epi8(MineCell::BOMB);
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(cells + i));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_and_si128(v, mask));
+    }
+#endif
+    for (; i < n; ++i) out[i] = cells[i] & MineCell::BOMB;
+}
+
+void MineNeighborPlane::sumRows (uint8_t* out, const uint8_t* a, const uint8_t* b, const uint8_t* c, int n) {
+    int i = 0;
+#if defined(__AVX2__)
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_add_epi8(_mm256_loadu_si256((const __m256i*)(a + i)), _mm256_loadu_si256((const __m256i*)(b + i)));
+        v = _mm256_add_epi8(v, _mm256_loadu_si256((const __m256i*)(c + i)));
+        _mm256_storeu_si256((__m256i*)(out + i), v);
+    }
+#elif defined(__SSE2__)
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_add_epi8(_mm_loadu_si128((const __m128i*)(a + i)), _mm_loadu_si128((const __m128i*)(b + i)));
+        v = _mm_add_epi8(v, _mm_loadu_si128((const __m128i*)(c + i)));
+        _mm_storeu_si128((__m128i*)(out + i), v);
+    }
+#endif
+    for (; i < n; ++i) out[i] = a[i] + b[i] + c[i];
+}
+
+void MineNeighborPlane::packCounts (CellState* cells, const uint8_t* sums, const uint8_t* bombs, int n) {
+    int i = 0;
+#if defined(__AVX2__)
+    const __m256i stateMask = _mm256_set1_epi8((char)~MineCell::COUNT_MASK);
+    const __m256i countMask = _mm256_set1_epi8((char)MineCell::COUNT_MASK);
+    for (; i + 32 <= n; i += 32) {
+        __m256i count = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i*)(sums + i)), _mm256_loadu_si256((const __m256i*)(bombs + i)));
+        // counts are at most 8, so shifting 16-bit lanes never carries across bytes
+        count = _mm256_and_si256(_mm256_slli_epi16(count, MineCell::COUNT_SHIFT), countMask);
+        __m256i state = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(cells + i)), stateMask);
+        _mm256_storeu_si256((__m256i*)(cells + i), _mm256_or_si256(state, count));
+    }
+#elif defined(__SSE2__)
+    const __m128i stateMask = _mm_set1_epi8((char)~MineCell::COUNT_MASK);
+    const __m128i countMask = _mm_set1_epi8((char)MineCell::COUNT_MASK);
+    for (; i + 16 <= n; i += 16) {
+        __m128i count = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)(sums + i)), _mm_loadu_si128((const __m128i*)(bombs + i)));
+        // counts are at most 8, so shifting 16-bit lanes never carries across bytes
+        count = _mm_and_si128(_mm_slli_epi16(count, MineCell::COUNT_SHIFT), countMask);
+        __m128i state = _mm_and_si128(_mm_loadu_si128((const __m128i*)(cells + i)), stateMask);
+        _mm_storeu_si128((__m128i*)(cells + i), _mm_or_si128(state, count));
+    }
+#endif
+    for (; i < n; ++i) cells[i] = MineCell::withNeighborBombsCount(cells[i], sums[i] - bombs[i]);
+}
\ No newline at end of file
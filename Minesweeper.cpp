@@ -1,10 +1,36 @@
+#include <cstring>
 #include <iostream>
 
+#include "MinesweeperBatch.h"
+#include "MinesweeperCommandReader.h"
 #include "MinesweeperGameManager.h"
 
 using namespace std;
 
-int main() {
+int main(int argc, char** argv) {
+	// --batch [file] [--csv]: apply the commands of file (stdin if omitted or -) headless, results on stdout
+	bool batch = false, csv = false;
+	const char* path = nullptr;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--batch") == 0) batch = true;
+		else if (strcmp(argv[i], "--csv") == 0) csv = true;
+		else if (batch && path == nullptr) path = argv[i];
+		else {
+			cerr << "Usage: " << argv[0] << " [--batch [file] [--csv]]" << endl;
+			return 2;
+		}
+	}
+	if (batch) {
+		MinesweeperCommandReader* reader = path == nullptr || strcmp(path, "-") == 0 ? new MinesweeperCommandReader(stdin) : MinesweeperCommandReader::open(path);
+		if (reader == nullptr) {
+			cerr << "Can't open " << path << endl;
+			return 1;
+		}
+		MinesweeperBatch runner(csv);
+		runner.run(*reader);
+		delete reader;
+		return 0;
+	}
 	MinesweeperGameManager Game;
 	Game.start();
 	return 0;
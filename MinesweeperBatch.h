@@ -0,0 +1,287 @@
+#pragma once
+
+// Headless mode: applies a stream of commands to a field without rendering and reports every result on stdout,
+// one JSON object per line or one CSV row per line
+// Commands, one per line, blank lines and lines starting with # are skipped:
+//   new <rows> <columns> <bombs> [seed]   start a field, bombs are placed by the first reveal from seed (random if omitted)
+//   reveal <row> <column>                 reveal a cell
+//   flag <row> <column>                   flag or unflag a cell
+//   chord <row> <column>                  reveal the neighbors of a revealed number once as many flags surround it
+//   save                                  save the field to the records journal, a failed write is reported at the next
+//                                         verify or at the end
+//   verify [id]                           replay the move log of the field, or of saved record id, and check the outcome
+// Moves report the cells they opened, then the field state (playing, won or lost), unrevealed cells and flags left
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "MineField.h"
+#include "MinesweeperCommandReader.h"
+#include "MinesweeperFrame.h"
+#include "MinesweeperJournal.h"
+#include "MinesweeperReplay.h"
+#include "MinesweeperSaveWorker.h"
+
+using namespace std;
+
+class MinesweeperBatch {
+    private:
+
+    MinesweeperFrame output; // results waiting to be written
+
+    bool csv; // CSV rows instead of JSON lines
+
+    MineField* field; // field the moves apply to, nullptr before the first new
+
+    bool lost; // a move of the field hit a bomb
+
+    MinesweeperJournal journal; // where save puts the field
+
+    MinesweeperSaveWorker saver {journal}; // writes the saves off the command loop
+
+    bool journalLoaded; // the journal index is only read by the first save or verify of a record
+
+    MinesweeperReplay replayer; // rebuilds the fields verify checks
+
+    void appendText (string_view text);
+    // append text, escaped as a JSON string or a CSV field
+
+    void report (long line, string_view command, long row, long column, const char* valueName, uint64_t value, const string &error, bool withField = true);
+    // append the result of a command: row and column are -1 for commands without a cell, valueName nullptr without a value
+    // withField false leaves out the state of the field, for a command that failed to replace it
+
+    void move (long line, string_view command, MinesweeperCommandReader &reader);
+    // apply a reveal, flag or chord and report it
+
+    void verify (long line, string_view command, MinesweeperCommandReader &reader);
+    // replay the field or a saved record and report the moves replayed
+
+    void loadJournal ();
+    // read the journal index on first use
+
+    void reportSaveErrors (long line);
+    // wait for the queued saves and report the ones the save worker gave up on, as failed save commands
+
+    public:
+
+    static const size_t FLUSH_SIZE = 1 << 16; // output is written once this many bytes are buffered
+
+    uint64_t commandsCount; // commands applied, errors included
+
+    uint64_t errorsCount; // commands that failed
+
+    MinesweeperBatch (bool csv = false, string journalPath = "MinesweeperRecords.dat");
+    // constructor, save and verify use the records journal at journalPath
+
+    ~MinesweeperBatch ();
+    // delete the field, the save worker writes what is still queued
+
+    MinesweeperBatch (const MinesweeperBatch&) = delete;
+
+    MinesweeperBatch& operator= (const MinesweeperBatch&) = delete;
+
+    void run (MinesweeperCommandReader &reader);
+    // apply every command of reader and write the results
+};
+
+MinesweeperBatch::MinesweeperBatch (bool csv, string journalPath) : output(FLUSH_SIZE * 2), journal(journalPath) {
+    this->csv = csv;
+    field = nullptr;
+    lost = false;
+    journalLoaded = false;
+    commandsCount = 0;
+    errorsCount = 0;
+}
+
+MinesweeperBatch::~MinesweeperBatch () {
+    delete field;
+}
+
+void MinesweeperBatch::appendText (string_view text) {
+    output.append('"');
+    for (char c : text) {
+        if (csv) {
+            // CSV doubles its quotes, nothing else needs escaping inside a quoted field
+            if (c == '"') output.append('"');
+            output.append(c);
+        }
+        else if (c == '"' || c == '\\') {
+            output.append('\\');
+            output.append(c);
+        }
+        else if ((unsigned char)c < 0x20) output.append(' ');
+        else output.append(c);
+    }
+    output.append('"');
+}
+
+void MinesweeperBatch::report (long line, string_view command, long row, long column, const char* valueName, uint64_t value, const string &error, bool withField) {
+    const MineField* shown = withField ? field : nullptr;
+    const char* state = shown == nullptr ? (withField ? "none" : "") : lost ? "lost" : shown->unrevealedCellsCount == shown->bombsCount ? "won" : "playing";
+    if (csv) {
+        // line,command,row,column,value,state,unrevealed,flags,error
+        output.appendInt(line);
+        output.append(',');
+        appendText(command);
+        output.append(',');
+        if (row >= 0) output.appendInt(row);
+        output.append(',');
+        if (column >= 0) output.appendInt(column);
+        output.append(',');
+        if (valueName != nullptr) output.appendUnsigned(value);
+        output.append(',');
+        output.append(state);
+        output.append(',');
+        if (shown != nullptr) output.appendInt(shown->unrevealedCellsCount);
+        output.append(',');
+        if (shown != nullptr) output.appendInt(shown->flagsCount);
+        output.append(',');
+        if (!error.empty()) appendText(error);
+        output.append('\n');
+    }
+    else {
+        output.append("{\"line\":");
+        output.appendInt(line);
+        output.append(",\"command\":");
+        appendText(command);
+        if (row >= 0) {
+            output.append(",\"row\":");
+            output.appendInt(row);
+            output.append(",\"column\":");
+            output.appendInt(column);
+        }
+        if (!error.empty()) {
+            output.append(",\"error\":");
+            appendText(error);
+        }
+        else if (valueName != nullptr) {
+            output.append(",\"");
+            output.append(valueName);
+            output.append("\":");
+            output.appendUnsigned(value);
+        }
+        if (shown != nullptr) {
+            output.append(",\"state\":\"");
+            output.append(state);
+            output.append("\",\"unrevealed\":");
+            output.appendInt(shown->unrevealedCellsCount);
+            output.append(",\"flags\":");
+            output.appendInt(shown->flagsCount);
+        }
+        output.append("}\n");
+    }
+    if (output.size() >= FLUSH_SIZE) output.flush();
+}
+
+void MinesweeperBatch::move (long line, string_view command, MinesweeperCommandReader &reader) {
+    long row, column;
+    if (!reader.number(row) || !reader.number(column) || !reader.lineEnded()) {
+        report(line, command, -1, -1, nullptr, 0, "expected a row and a column");
+        ++errorsCount;
+        return;
+    }
+    string error;
+    if (field == nullptr) error = "no field, start one with new";
+    else if (lost || field->unrevealedCellsCount == field->bombsCount) error = "the game is over, start a new one";
+    else if (!field->board.contains(row, column)) error = "the cell is outside the field";
+    if (!error.empty()) {
+        report(line, command, row, column, nullptr, 0, error);
+        ++errorsCount;
+        return;
+    }
+    int unrevealed = field->unrevealedCellsCount;
+    if (command == "flag") field->flag(row, column);
+    else if (command == "reveal") lost = field->reveal(row, column, false, false);
+    else lost = field->chord(row, column);
+    report(line, command, row, column, "opened", unrevealed - field->unrevealedCellsCount, error);
+}
+
+void MinesweeperBatch::loadJournal () {
+    if (journalLoaded) return;
+    vector <string> errors;
+    journal.load(errors);
+    journalLoaded = true;
+}
+
+void MinesweeperBatch::reportSaveErrors (long line) {
+    saver.flush();
+    for (string &error : saver.takeErrors()) {
+        report(line, "save", -1, -1, nullptr, 0, error);
+        ++errorsCount;
+    }
+}
+
+void MinesweeperBatch::verify (long line, string_view command, MinesweeperCommandReader &reader) {
+    long id = 0;
+    if (!reader.lineEnded() && (!reader.number(id) || id < 1 || !reader.lineEnded())) {
+        report(line, command, -1, -1, nullptr, 0, "expected an optional record id");
+        ++errorsCount;
+        return;
+    }
+    string error;
+    const MineField* saved = field;
+    MineField* opened = nullptr;
+    if (id > 0) {
+        loadJournal();
+        // a save still queued for the record has to reach the journal first
+        reportSaveErrors(line);
+        MinesweeperRecordInfo info;
+        info.id = id;
+        saved = opened = journal.open(info, error);
+    }
+    else if (field == nullptr) error = "no field, start one with new";
+    if (saved != nullptr && replayer.replay(*saved, error)) report(line, command, -1, -1, "moves", saved->moves.count, "");
+    else {
+        report(line, command, -1, -1, nullptr, 0, error);
+        ++errorsCount;
+    }
+    delete opened;
+}
+
+void MinesweeperBatch::run (MinesweeperCommandReader &reader) {
+    if (csv) output.append("line,command,row,column,value,state,unrevealed,flags,error\n");
+    string_view command;
+    while (reader.nextLine()) {
+        long line = reader.lineNumber;
+        if (!reader.word(command) || command[0] == '#') continue;
+        ++commandsCount;
+        if (command == "reveal" || command == "flag" || command == "chord") move(line, command, reader);
+        else if (command == "new") {
+            long rows, columns, bombs;
+            uint64_t seed = 0;
+            bool seeded = false;
+            bool valid = reader.number(rows) && reader.number(columns) && reader.number(bombs) && (reader.lineEnded() || (seeded = reader.unsignedNumber(seed))) && reader.lineEnded();
+            // 18-digit sizes would overflow rows * columns, the product is only formed once it is known to fit
+            if (!valid || rows < 1 || columns < 1 || bombs < 1 || rows > INT32_MAX / columns || bombs >= rows * columns) {
+                // the field in play stays, but it isn't what this line was about
+                report(line, command, -1, -1, nullptr, 0, "expected rows, columns, bombs (fewer than the cells) and an optional seed", false);
+                ++errorsCount;
+                continue;
+            }
+            delete field;
+            field = new MineField(rows, columns, bombs);
+            if (seeded) field->seed = seed;
+            lost = false;
+            report(line, command, -1, -1, "seed", field->seed, "");
+        }
+        else if (command == "save") {
+            if (field == nullptr || !reader.lineEnded()) {
+                report(line, command, -1, -1, nullptr, 0, field == nullptr ? "no field, start one with new" : "save takes no arguments");
+                ++errorsCount;
+                continue;
+            }
+            loadJournal();
+            field->save();
+            saver.save(*field);
+            report(line, command, -1, -1, "id", field->recordId, "");
+        }
+        else if (command == "verify") verify(line, command, reader);
+        else {
+            report(line, command, -1, -1, nullptr, 0, "unknown command");
+            ++errorsCount;
+        }
+    }
+    reportSaveErrors(reader.lineNumber);
+    output.flush();
+}
\ No newline at end of file
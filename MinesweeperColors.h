@@ -1,41 +1,125 @@
+#pragma once
+
 // Outputing text with different colors in console
+// Every cell byte maps to a color id through a precomputed table, every color id to its ANSI escape sequence
+// The frame remembers the color in effect, so a run of glyphs of one color costs a single escape
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
 
-#include <map>
+#include "MineCell.h"
+#include "MinesweeperFrame.h"
 
 using namespace std;
 
 class MinesweeperColors {
+    public:
+
+    enum Color {DEFAULT, ONE, TWO, THREE, FOUR, FIVE, SIX, SEVEN, EIGHT, FLAG, BOMB, WRONG_FLAG, COLORS_COUNT};
+
+    static const int ANY = -1; // color of blank glyphs: they look the same in every color, so they never switch it
+
     private:
 
-    map<string, int> colorMap;
+    bool enabled; // false when the NO_COLOR environment variable is set, nothing but plain glyphs is written then
+
+    array <int8_t, 256> cellColors; // color id of every cell byte
+
+    array <string, COLORS_COUNT> escapes; // escape sequence of every color id
 
     public:
 
     MinesweeperColors ();
 
-    void addColor(string representative, int value);
-    // add new color to the map
+    bool isEnabled () const;
+    // check if colored output is on
+
+    void setEnabled (bool enabled);
+    // turn colored output on or off
+
+    int cellColor (CellState cell) const;
+    // color id of the glyph drawn for the cell
+
+    const string& escape (int color) const;
+    // ANSI escape sequence selecting a color id
+
+    void append (MinesweeperFrame &frame, char glyph, int color) const;
+    // append glyph in color, switching the color only if the frame is not already in it
 
-    int getColor(string representative);
-    // get color value from the representative string
+    void appendCell (MinesweeperFrame &frame, CellState cell) const;
+    // append the glyph of the cell in its color
 
-    void outputText(string representative);
-    // ouput the representative text with its color
+    void reset (MinesweeperFrame &frame) const;
+    // switch the frame back to the default color
+
+    void outputText (string text, int color);
+    // ouput the text with its color straight to the console
 };
 
 MinesweeperColors::MinesweeperColors () {
-    addColor("|", 12);
-    addColor("0", 13);
+    enabled = getenv("NO_COLOR") == nullptr;
+    for (int value = 0; value < 256; ++value) {
+        CellState state = (CellState)value;
+        if (!MineCell::revealed(state)) cellColors[value] = MineCell::flagged(state) ? FLAG : DEFAULT;
+        else if (MineCell::hasBomb(state)) cellColors[value] = MineCell::flagged(state) ? WRONG_FLAG : BOMB;
+        else if (MineCell::neighborBombsCount(state) == 0) cellColors[value] = ANY;
+        else cellColors[value] = DEFAULT + MineCell::neighborBombsCount(state);
+    }
+    // the classic minesweeper number colors, on the 16-color palette every terminal has
+    escapes = {
+        "\033[m",        // DEFAULT: hidden cells, separators, borders and text
+        "\033[94m",      // 1: blue
+        "\033[32m",      // 2: green
+        "\033[91m",      // 3: red
+        "\033[34m",      // 4: dark blue
+        "\033[31m",      // 5: dark red
+        "\033[36m",      // 6: cyan
+        "\033[35m",      // 7: magenta
+        "\033[90m",      // 8: gray
+        "\033[1;91m",    // FLAG: bold red
+        "\033[1;97;41m", // BOMB: white on red
+        "\033[1;93m"     // WRONG_FLAG: bold yellow
+    };
+}
+
+bool MinesweeperColors::isEnabled () const {
+    return enabled;
+}
+
+void MinesweeperColors::setEnabled (bool enabled) {
+    this->enabled = enabled;
+}
+
+int MinesweeperColors::cellColor (CellState cell) const {
+    return cellColors[cell];
+}
+
+const string& MinesweeperColors::escape (int color) const {
+    return escapes[color];
+}
+
+void MinesweeperColors::append (MinesweeperFrame &frame, char glyph, int color) const {
+    if (enabled && color != ANY && color != frame.color()) {
+        frame.append(escape(color));
+        frame.setColor(color);
+    }
+    frame.append(glyph);
 }
 
-void MinesweeperColors::addColor (string representative, int value) {
-    colorMap.insert(pair<string ,int>(representative, value));
+void MinesweeperColors::appendCell (MinesweeperFrame &frame, CellState cell) const {
+    append(frame, MineCell::glyph(cell), cellColor(cell));
 }
 
-int MinesweeperColors::getColor(string representative) {
-    return colorMap.at(representative);
+void MinesweeperColors::reset (MinesweeperFrame &frame) const {
+    if (frame.color() == DEFAULT) return;
+    frame.append(escape(DEFAULT));
+    frame.setColor(DEFAULT);
 }
 
-void MinesweeperColors::outputText(string representative) {
-    int color = getColor(representative);
+void MinesweeperColors::outputText (string text, int color) {
+    if (enabled && color != ANY && color != DEFAULT) cout << escape(color) << text << escape(DEFAULT);
+    else cout << text;
 }
\ No newline at end of file
@@ -0,0 +1,169 @@
+#pragma once
+
+// Line and word tokenizer for command streams (files or pipes), reading big chunks and never copying a line:
+// lines and words are string_views into the chunk buffer, valid until the next call to nextLine
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+class MinesweeperCommandReader {
+    private:
+
+    FILE* input; // stream the commands come from
+
+    bool owned; // input was opened here and is closed by the destructor
+
+    vector <char> buffer; // chunk being tokenized, grows to hold the longest line
+
+    size_t start, end; // unread bytes of buffer
+
+    bool finished; // input has no more bytes
+
+    string_view line; // current line, without its line break
+
+    size_t cursor; // position of the next word in line
+
+    bool refill ();
+    // move the unread bytes to the front of buffer and read more after them, false if nothing was read
+
+    static bool isSpace (char c);
+
+    public:
+
+    static const size_t CHUNK_SIZE = 1 << 20;
+
+    long lineNumber; // 1-based number of the current line
+
+    MinesweeperCommandReader (FILE* input, bool owned = false);
+    // constructor, reads input from its current position
+
+    ~MinesweeperCommandReader ();
+    // close input if it was opened here
+
+    MinesweeperCommandReader (const MinesweeperCommandReader&) = delete;
+
+    MinesweeperCommandReader& operator= (const MinesweeperCommandReader&) = delete;
+
+    static MinesweeperCommandReader* open (const char* path);
+    // reader of the file at path, nullptr if it can't be opened
+
+    bool nextLine ();
+    // move to the next line, false at the end of the input
+
+    bool word (string_view &word);
+    // next whitespace-separated word of the line, false if there is none left
+
+    bool number (long &value);
+    // next word of the line as a decimal integer, false if there is none or it is not a number
+
+    bool unsignedNumber (uint64_t &value);
+    // next word of the line as a decimal integer in the whole unsigned 64-bit range, false if there is none or it isn't one
+
+    bool lineEnded ();
+    // check if the line has no word left
+};
+
+MinesweeperCommandReader::MinesweeperCommandReader (FILE* input, bool owned) : buffer(CHUNK_SIZE) {
+    this->input = input;
+    this->owned = owned;
+    start = end = 0;
+    finished = false;
+    cursor = 0;
+    lineNumber = 0;
+}
+
+MinesweeperCommandReader::~MinesweeperCommandReader () {
+    if (owned) fclose(input);
+}
+
+MinesweeperCommandReader* MinesweeperCommandReader::open (const char* path) {
+    FILE* file = fopen(path, "rb");
+    return file == nullptr ? nullptr : new MinesweeperCommandReader(file, true);
+}
+
+bool MinesweeperCommandReader::isSpace (char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+bool MinesweeperCommandReader::refill () {
+    if (finished) return false;
+    memmove(buffer.data(), buffer.data() + start, end - start);
+    end -= start;
+    start = 0;
+    // a line longer than the buffer doubles it
+    if (end == buffer.size()) buffer.resize(buffer.size() * 2);
+    size_t count = fread(buffer.data() + end, 1, buffer.size() - end, input);
+    end += count;
+    if (count == 0) finished = true;
+    return count > 0;
+}
+
+bool MinesweeperCommandReader::nextLine () {
+    size_t searched = start;
+    while (true) {
+        const char* lineBreak = (const char*)memchr(buffer.data() + searched, '\n', end - searched);
+        if (lineBreak != nullptr) {
+            size_t length = lineBreak - (buffer.data() + start);
+            line = string_view(buffer.data() + start, length);
+            start += length + 1;
+            break;
+        }
+        // the bytes searched so far move to the front of the buffer with the rest of the line
+        size_t scanned = end - start;
+        if (!refill()) {
+            // the last line may have no line break
+            if (start == end) return false;
+            line = string_view(buffer.data() + start, end - start);
+            start = end;
+            break;
+        }
+        searched = start + scanned;
+    }
+    cursor = 0;
+    ++lineNumber;
+    return true;
+}
+
+bool MinesweeperCommandReader::word (string_view &word) {
+    while (cursor < line.size() && isSpace(line[cursor])) ++cursor;
+    size_t from = cursor;
+    while (cursor < line.size() && !isSpace(line[cursor])) ++cursor;
+    word = line.substr(from, cursor - from);
+    return cursor > from;
+}
+
+bool MinesweeperCommandReader::number (long &value) {
+    string_view text;
+    if (!word(text)) return false;
+    size_t i = text[0] == '-' ? 1 : 0;
+    if (i == text.size() || text.size() - i > 18) return false;
+    value = 0;
+    for (; i < text.size(); ++i) {
+        if (text[i] < '0' || text[i] > '9') return false;
+        value = value * 10 + (text[i] - '0');
+    }
+    if (text[0] == '-') value = -value;
+    return true;
+}
+
+bool MinesweeperCommandReader::unsignedNumber (uint64_t &value) {
+    string_view text;
+    if (!word(text) || text.size() > 20) return false;
+    value = 0;
+    for (char c : text) {
+        // the digit is only added if the value stays below 2^64
+        if (c < '0' || c > '9' || value > (UINT64_MAX - (c - '0')) / 10) return false;
+        value = value * 10 + (c - '0');
+    }
+    return true;
+}
+
+bool MinesweeperCommandReader::lineEnded () {
+    while (cursor < line.size() && isSpace(line[cursor])) ++cursor;
+    return cursor == line.size();
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+// Durable file updates: flush a written file to the disk, or swap in a finished temporary file so that a crash
+// at any point leaves either the old or the new file whole, never a torn one
+
+#include <cstdio>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+class MinesweeperFileSync {
+    private:
+
+    static void syncDirectory (const string &path);
+    // flush the directory entries of the directory holding path, so a rename survives a crash (best effort)
+
+    public:
+
+    static bool sync (const string &path);
+    // flush the contents of the file at path to the disk
+
+    static bool replace (const string &temporaryPath, const string &path);
+    // flush temporaryPath, rename it over path and flush the rename, true once path is the new file
+};
+
+bool MinesweeperFileSync::sync (const string &path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    bool synced = FlushFileBuffers(file);
+    CloseHandle(file);
+    return synced;
+#else
+    int file = open(path.c_str(), O_WRONLY);
+    if (file < 0) return false;
+    bool synced = fsync(file) == 0;
+    close(file);
+    return synced;
+#endif
+}
+
+void MinesweeperFileSync::syncDirectory (const string &path) {
+#ifndef _WIN32
+    // MoveFileEx with MOVEFILE_WRITE_THROUGH already waits for the rename on Windows
+    size_t slash = path.rfind('/');
+    string directory = slash == string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int file = open(directory.c_str(), O_RDONLY);
+    if (file < 0) return;
+    fsync(file);
+    close(file);
+#endif
+}
+
+bool MinesweeperFileSync::replace (const string &temporaryPath, const string &path) {
+    if (!sync(temporaryPath)) return false;
+#ifdef _WIN32
+    // rename refuses to replace an existing file on Windows
+    if (!MoveFileExA(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) return false;
+#else
+    if (rename(temporaryPath.c_str(), path.c_str()) != 0) return false;
+#endif
+    syncDirectory(path);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#pragma once
+
+// Output buffer for one screen frame: composed in memory, then emitted with a single write
+
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+class MinesweeperFrame {
+    private:
+
+    string buffer; // frame bytes, keeps its capacity across frames
+
+    int currentColor; // color id in effect on the terminal after the buffered bytes, 0 is the default color
+
+    public:
+
+    MinesweeperFrame (size_t capacity = 1 << 16);
+    // constructor, preallocates capacity bytes
+
+    void begin ();
+    // start a new frame, reusing the buffer
+
+    void append (char c);
+
+    void append (const char* text);
+
+    void append (const string &text);
+
+    void appendRepeat (char c, int count);
+    // append count copies of c
+
+    void appendInt (long number);
+    // append the decimal form of number
+
+    void appendUnsigned (uint64_t number);
+    // append the decimal form of number, the whole 64-bit range
+
+    size_t size () const;
+    // number of bytes in the current frame
+
+    int color () const;
+    // color id in effect after the buffered bytes
+
+    void setColor (int color);
+    // record that the bytes just appended switched the terminal to color
+
+    size_t flush ();
+    // write the frame to stdout in one call and start a new one, returns the number of bytes written
+};
+
+MinesweeperFrame::MinesweeperFrame (size_t capacity) {
+    buffer.reserve(capacity);
+    currentColor = 0;
+}
+
+void MinesweeperFrame::begin () {
+    buffer.clear();
+}
+
+void MinesweeperFrame::append (char c) {
+    buffer.push_back(c);
+}
+
+void MinesweeperFrame::append (const char* text) {
+    buffer.append(text);
+}
+
+void MinesweeperFrame::append (const string &text) {
+    buffer.append(text);
+}
+
+void MinesweeperFrame::appendRepeat (char c, int count) {
+    if (count > 0) buffer.append(count, c);
+}
+
+void MinesweeperFrame::appendInt (long number) {
+    if (number < 0) buffer.push_back('-');
+    appendUnsigned(number < 0 ? 0ull - (uint64_t)number : (uint64_t)number);
+}
+
+void MinesweeperFrame::appendUnsigned (uint64_t number) {
+    // digits are produced backwards into a small array, no format string to parse
+    char digits[24];
+    char* end = digits + sizeof(digits), *cursor = end;
+    do {
+        *--cursor = '0' + number % 10;
+        number /= 10;
+    } while (number != 0);
+    buffer.append(cursor, end - cursor);
+}
+
+size_t MinesweeperFrame::size () const {
+    return buffer.size();
+}
+
+int MinesweeperFrame::color () const {
+    return currentColor;
+}
+
+void MinesweeperFrame::setColor (int color) {
+    currentColor = color;
+}
+
+size_t MinesweeperFrame::flush () {
+    // anything still buffered in cout (prompts) has to go out first to keep the order
+    cout.flush();
+    size_t written = 0;
+    while (written < buffer.size()) {
+#ifdef _WIN32
+        int result = _write(1, buffer.data() + written, (unsigned int)(buffer.size() - written));
+#else
+        ssize_t result = write(STDOUT_FILENO, buffer.data() + written, buffer.size() - written);
+#endif
+        if (result <= 0) break;
+        written += result;
+    }
+    buffer.clear();
+    return written;
+}
\ No newline at end of file
@@ -1,10 +1,26 @@
+#pragma once
+
+// The game is a state machine: start() runs one loop that renders the screen of the current state, reads the next
+// command (one whitespace-separated word, or the rest of the line for a name) and applies it, so the stack stays flat
+// however long the session is
+// Words typed on one line are applied together, only the state after the last one is rendered
+
 #include <vector>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <iomanip>
 #include <string>
 #include <sstream>
 
 #include "MineField.h"
+#include "MinesweeperJournal.h"
+#include "MinesweeperLeaderboard.h"
+#include "MinesweeperMappedFile.h"
+#include "MinesweeperRecord.h"
+#include "MinesweeperSaveWorker.h"
+#include "MinesweeperTextParser.h"
+#include "MinesweeperRenderer.h"
 
 using namespace std;
 
@@ -12,222 +28,444 @@ using namespace std;
 class MinesweeperGameManager {
     public:
 
-    vector <MineField*> records;
+    enum State {
+        START_MENU, // main menu
+        CREATE, // asking the size of a new field, arguments holds the answers so far
+        CHOOSE_RECORD, // list of the saved games
+        PLAYING, // in game, arguments holds the row and column of a move being typed
+        SAVE_PROMPT, // leaving a game, asking whether to save it
+        HIGH_SCORE_NAME, // won with a high score, asking the player name
+        END_GAME, // game won or lost, asking whether to go back to the menu
+        HIGH_SCORES, // high scores of every difficulty
+        QUITTING // the loop ends
+    };
+
+    State state = START_MENU; // what the next command answers
+
+    string line; // last line read, its words from cursor on are not applied yet
+
+    size_t cursor = 0; // position of the next unread character of line
+
+    vector <int> arguments; // numbers collected by a command spanning several words
+
+    string endText; // outcome shown by the end game screen
+
+    MinesweeperScore pendingScore; // high score waiting for the player name
+
+    vector <MinesweeperRecordInfo> records; // saved games as listed by the journal index, a board is only read once chosen
+
+    vector <string> recordErrors; // why records of the last fetch were dropped, with their location in the file
+
+    MinesweeperJournal journal {"MinesweeperRecords.dat"}; // saved games, appended to on every save
+
+    MinesweeperSaveWorker saver {journal}; // writes the saves and removals to the journal off the input thread
+
+    int autosaveMoves = 20; // moves between two autosaves of the current game, 0 to turn autosave off
+
+    int movesSinceSave = 0; // moves played since the current game was last saved
+
+    MinesweeperLeaderboard leaderboard {"MinesweeperScores.dat"}; // best results of every difficulty
 
-    MineField* currentData;
+    bool recordsFetched = false; // the journal is loaded once, the menus list its index from memory afterwards
 
-    vector <string> startMenuOptions {"Start a new game", "Load an existing game", "Quit"};
+    MineField* currentData = nullptr;
+
+    vector <string> startMenuOptions {"Start a new game", "Load an existing game", "High scores", "Quit"};
 
     MinesweeperUtils Utils;
 
+    MinesweeperRenderer renderer; // keeps the drawn frame, so a move only redraws what changed
+
+    ~MinesweeperGameManager ();
+    // delete the current field, the save worker writes what is still queued
+
+    void start ();
+    // run the game until the player quits or the input ends
+
+    bool readCommand (string &command, bool wholeLine);
+    // input phase: the next word, or the rest of the line if wholeLine, reading a line when none is left
+    // false at the end of the input
+
+    bool pendingInput ();
+    // check if the last line read still has words to apply
+
+    void update (const string &command);
+    // update phase: apply command to the current state
+
+    void render ();
+    // render phase: draw the screen and the prompt of the current state
+
+    void enter (State next);
+    // switch to state next, dropping the words collected by the previous command
+
+    int toInt (const string &command);
+    // the number in command, -1 if it is not a number
+
     void load (MineField* data);
     // load game from given data
 
-    void create();
-    // Create new game
+    void create (const string &command);
+    // answer one question about the new field, the last answer starts the game
 
     void fetchRecords();
-    // get Records from file
+    // get Records from the records journal, or migrate the legacy text file if there is no journal yet, and the high scores
+
+    void fetchLegacyRecords(vector <MineField*> &fields);
+    // get the fields saved in the legacy text file (one digit per cell)
 
-    void start();
-    // start the game
+    void chooseMenu (const string &command);
+    // apply a start menu option
 
     void gameOver ();
     // Gameover the player
 
-    void render ();
-    // render the minefield to the console
-
-    void startProcess ();
-    // start the user input reccursive process
+    void play (const string &command);
+    // apply one word of a move: a scroll key, or the row, column and flag of a cell
 
     void save ();
-    // save the current record
+    // save the current record in the background
 
-    void chooseRecord ();
-    // userInput choose record
+    void chooseRecord (const string &command);
+    // open the chosen saved game
 
-    void exportRecords();
-    // export records to file
+    void renderRecords ();
+    // list the saved games and the records that couldn't be read
 
     void removeRecord (MineField* data);
-    // clear the specified record from the records list
+    // tombstone the specified record in the journal, in the background
 
-    void quit(bool needSave);
-    // quit the game
+    void quit (const string &command);
+    // answer the save prompt and quit
 
     void win ();
-    // user wins the game
+    // user wins the game, the result goes to the high scores if it is good enough
+
+    void nameHighScore (const string &command);
+    // record the pending high score under the name in command
 
-    void endGameSelection (string text);
-    // display endgame with text
+    void renderHighScores ();
+    // list the high scores of every difficulty
+
+    void endGame (string text);
+    // save the outcome of the finished game and show it with text
+
+    void endGameSelection (const string &command);
+    // go back to the menu or quit after a finished game
 };
 
+MinesweeperGameManager::~MinesweeperGameManager () {
+    delete currentData;
+}
+
+void MinesweeperGameManager::start () {
+    if (!recordsFetched) fetchRecords();
+    string command;
+    while (state != QUITTING) {
+        // a batch of words renders once, after its last word
+        if (!pendingInput()) render();
+        // a name may have spaces, it takes the rest of the line instead of one word
+        if (!readCommand(command, state == HIGH_SCORE_NAME)) break;
+        update(command);
+    }
+    // the last saves are only known to be kept once the worker is done with them
+    saver.flush();
+    for (string &error : saver.takeErrors()) cout << "Couldn't save a game: " << error << endl;
+    cout << "Quitting game" << endl;
+    cout << "Thanks for playing!";
+}
+
+bool MinesweeperGameManager::pendingInput () {
+    return line.find_first_not_of(" \t\r\v\f", cursor) != string::npos;
+}
+
+bool MinesweeperGameManager::readCommand (string &command, bool wholeLine) {
+    const char* spaces = " \t\r\v\f";
+    while (!pendingInput()) {
+        if (!getline(cin, line)) return false;
+        cursor = 0;
+    }
+    cursor = line.find_first_not_of(spaces, cursor);
+    size_t end = wholeLine ? line.find_last_not_of(spaces) + 1 : min(line.find_first_of(spaces, cursor), line.size());
+    command = line.substr(cursor, end - cursor);
+    cursor = wholeLine ? line.size() : end;
+    return true;
+}
+
+void MinesweeperGameManager::update (const string &command) {
+    switch (state) {
+        case START_MENU:
+            chooseMenu(command);
+            break;
+        case CREATE:
+            create(command);
+            break;
+        case CHOOSE_RECORD:
+            chooseRecord(command);
+            break;
+        case PLAYING:
+            play(command);
+            break;
+        case SAVE_PROMPT:
+            quit(command);
+            break;
+        case HIGH_SCORE_NAME:
+            nameHighScore(command);
+            break;
+        case END_GAME:
+            endGameSelection(command);
+            break;
+        case HIGH_SCORES:
+            enter(START_MENU);
+            break;
+        case QUITTING:
+            break;
+    }
+}
+
+void MinesweeperGameManager::render () {
+    switch (state) {
+        case START_MENU:
+            Utils.clearConsole();
+            // the player was told the game was saved, a save the worker gave up on is shown once here
+            for (string &error : saver.takeErrors()) cout << "Couldn't save a game: " << error << endl;
+            cout << "Welcome to Minesweeper!" << endl;
+            cout << "Please choose a number below to start:" << endl;
+            for (size_t i = 0; i < startMenuOptions.size(); ++i) cout << i << ". " << startMenuOptions[i] << endl;
+            cout << "Your option: ";
+            break;
+        case CREATE:
+            if (arguments.size() == 0) {
+                Utils.clearConsole();
+                cout << "Please Enter field rows (minimum 2, -1 to back to menu): ";
+            }
+            else if (arguments.size() == 1) cout << "Please Enter field columns (minimum 2, -1 to back to menu): ";
+            else cout << "Please Enter field size (minimum 1, maximum (rows * columns - 1), -1 to back to menu): ";
+            break;
+        case CHOOSE_RECORD:
+            renderRecords();
+            break;
+        case PLAYING:
+            // the rest of a move being typed needs no new prompt
+            if (!arguments.empty()) break;
+            renderer.draw(*currentData);
+            cout << "Input row (from 0 to " << currentData->Height - 1 << "), column (from 0 to " << currentData->Width - 1 << ") position of a block and a flagged number (0 to open, 1 to flag)";
+            if (renderer.scrollable()) cout << ", w/a/s/d to scroll the view";
+            cout << ", -1 to exit: ";
+            break;
+        case SAVE_PROMPT:
+            cout << "Save this game? (-1: Cancel, 0: No, 1: Yes): ";
+            break;
+        case HIGH_SCORE_NAME:
+            renderer.draw(*currentData);
+            cout << "New high score! Enter your name: ";
+            break;
+        case END_GAME:
+            renderer.draw(*currentData);
+            cout << endText << endl;
+            cout << "Times played: " << Utils.convertTime(currentData->timesPlayed) << endl;
+            cout << "Type anything to back to menu, 0 to quit: ";
+            break;
+        case HIGH_SCORES:
+            renderHighScores();
+            break;
+        case QUITTING:
+            break;
+    }
+}
+
+void MinesweeperGameManager::enter (State next) {
+    state = next;
+    arguments.clear();
+}
+
+int MinesweeperGameManager::toInt (const string &command) {
+    return Utils.isInt(command) ? Utils.stoi(command) : -1;
+}
+
 void MinesweeperGameManager::load (MineField* data) {
-    records.push_back(data);
+    if (currentData != data) delete currentData;
     currentData = data;
-    startProcess();
+    movesSinceSave = 0;
+    // the menus cleared the screen, repaint the whole field once
+    renderer.invalidate();
+    enter(PLAYING);
 };
 
-void MinesweeperGameManager::create () {
-    Utils.clearConsole();
-    int mapSize, bombs;
-    cout << "Please Enter field size (minimum 2, -1 to back to menu): ";
-    Utils.readInt(mapSize);
-    if (mapSize < 0) {
-        start();
+void MinesweeperGameManager::create (const string &command) {
+    int answer = toInt(command);
+    if (answer < 0) {
+        enter(START_MENU);
         return;
     }
-    mapSize = max(mapSize, 2);
-    cout << "Please Enter field size (minimum 1, maximum (size^2 - 1), -1 to back to menu): ";
-    Utils.readInt(bombs);
-    if (bombs < 0) {
-        start();
-        return;
-    }
-    bombs = max(1, min(bombs, (int)pow(mapSize, 2) - 1));
-    load(new MineField(mapSize, bombs));
+    arguments.push_back(answer);
+    if (arguments.size() < 3) return;
+    int mapHeight = max(arguments[0], 2), mapWidth = max(arguments[1], 2);
+    int bombs = max(1, min(arguments[2], mapHeight * mapWidth - 1));
+    load(new MineField(mapHeight, mapWidth, bombs));
 };
 
 void MinesweeperGameManager::fetchRecords () {
-    records.clear();
-    ifstream recordsFile ("MinesweeperRecords.txt");
-    string content( (istreambuf_iterator<char>(recordsFile) ), (istreambuf_iterator<char>()    ) );
-    vector <string> rawRecords = Utils.splitString(content, "\n\n");
-    for (string rawRecord : rawRecords) {
-        vector <string> recordInfo = Utils.splitString(rawRecord, "\n");
-        while (recordInfo.size() < 4) recordInfo.push_back("0");
-        for (string &info : recordInfo) {
-            if (info == "") info = "0";
-        }
-        MineField* MF = new MineField((long)Utils.stoi(recordInfo[0]), (long)Utils.stoi(recordInfo[1]), Utils.stoi(recordInfo[2]), recordInfo[3]);
-        if (MF->valid) records.push_back(MF);
+    recordErrors.clear();
+    if (journal.exists()) journal.load(recordErrors);
+    else {
+        vector <MineField*> fields;
+        fetchLegacyRecords(fields);
+        journal.rewrite(fields);
+        for (MineField* MF : fields) delete MF;
     }
-    recordsFile.close();
-    exportRecords();
+    leaderboard.load();
+    recordsFetched = true;
 };
 
-void MinesweeperGameManager::exportRecords () {
-    ofstream recordsFile ("MinesweeperRecords.txt");
-    for (MineField* MF : records) {
-        recordsFile << MF->exportData() << endl << endl;
+void MinesweeperGameManager::fetchLegacyRecords (vector <MineField*> &fields) {
+    MinesweeperMappedFile recordsFile;
+    if (!recordsFile.open("MinesweeperRecords.txt")) return;
+    MinesweeperTextParser parser(recordsFile.text());
+    while (!parser.atEnd()) {
+        MineField* MF = parser.readRecord();
+        if (MF != nullptr) {
+            fields.push_back(MF);
+            continue;
+        }
+        recordErrors.push_back("MinesweeperRecords.txt, " + parser.error());
+        parser.skipRecord();
     }
     recordsFile.close();
 }
 
-void MinesweeperGameManager::chooseRecord () {
+void MinesweeperGameManager::chooseMenu (const string &command) {
+    switch (toInt(command)) {
+        case 0:
+            enter(CREATE);
+            break;
+        case 1:
+            // the list has to show the saves and removals still queued
+            saver.flush();
+            records = journal.list();
+            enter(CHOOSE_RECORD);
+            break;
+        case 2:
+            enter(HIGH_SCORES);
+            break;
+        case 3:
+            enter(QUITTING);
+    }
+}
+
+void MinesweeperGameManager::renderRecords () {
     Utils.clearConsole();
-    int i = 0, selection;
-    for (MineField* fieldData : records) {
-        cout << i++ << ". " << fieldData->savedTimestamp << " | Field size: " << fieldData->Size << ", Bombs: " << fieldData->bombsCount << endl; 
+    int i = 0;
+    for (MinesweeperRecordInfo &record : records) {
+        cout << i++ << ". " << record.savedTimestamp << " | Field size: " << record.height << "x" << record.width << ", Bombs: " << record.bombsCount << endl; 
     }
     if (records.size() == 0) cout << "NO RECORDS SAVED" << endl;
+    for (string &error : recordErrors) cout << "Skipped a damaged record: " << error << endl;
     cout << endl << "Choose a game from your saved records, -1 to go back: ";
-    Utils.readInt(selection);
-    if (selection < 0) start();
-    else if (selection >= 0 && selection < records.size()) load(records[selection]);
-    else chooseRecord();
+}
+
+void MinesweeperGameManager::chooseRecord (const string &command) {
+    int selection = toInt(command);
+    if (selection < 0) enter(START_MENU);
+    else if (selection < (int)records.size()) {
+        string error;
+        MineField* MF = journal.open(records[selection], error);
+        if (MF != nullptr) load(MF);
+        else recordErrors.push_back(error);
+    }
 };
 
 void MinesweeperGameManager::removeRecord (MineField* data) {
-    auto it = find(records.begin(), records.end(), data);
-    if (it != records.end()) records.erase(it);
+    saver.remove(data->recordId);
 }
 
 void MinesweeperGameManager::save () {
     currentData->save();
+    saver.save(*currentData);
+    movesSinceSave = 0;
 };
 
-void MinesweeperGameManager::start () {
-    Utils.clearConsole();
-    fetchRecords();
-    cout << "Welcome to Minesweeper!" << endl;
-    cout << "Please choose a number below to start:" << endl;
-    int menuSize = startMenuOptions.size();
-    for (int i = 0; i < menuSize; ++i) cout << i << ". " << startMenuOptions[i] << endl;
-    int option;
-    cout << "Your option: ";
-    Utils.readInt(option);
-    if (option < 0 || option >= menuSize) start();
-    else switch (option) {
-        case 0:
-            create();
-            break;
-        case 1:
-            chooseRecord();
-            break;
-        case 2:
-            quit(false);
-    }
-};
-
-void MinesweeperGameManager::endGameSelection (string str) {
+void MinesweeperGameManager::endGame (string text) {
     currentData->save();
-    render();
     removeRecord(currentData);
-    cout << str << endl;
-    cout << "Times played: " << Utils.convertTime(currentData->timesPlayed) << endl;
-    cout << "Type anything to back to menu, 0 to quit: ";
-    int selection;
-    Utils.readInt(selection);
-    if (selection == 0) quit(false);
-    else start();
+    endText = text;
+    enter(END_GAME);
+}
+
+void MinesweeperGameManager::endGameSelection (const string &command) {
+    if (toInt(command) == 0) enter(QUITTING);
+    else enter(START_MENU);
 }
 
 void MinesweeperGameManager::gameOver () {
     currentData->revealAllBombs();
-    endGameSelection("Oops! You digged deeper and caught a bomb! Too bad!");
+    endGame("Oops! You digged deeper and caught a bomb! Too bad!");
 }
 
 void MinesweeperGameManager::win () {
-    endGameSelection("You win!");
+    MinesweeperDifficulty difficulty {currentData->Width, currentData->Height, currentData->bombsCount};
+    MinesweeperScore score;
+    score.time = min <uint64_t>(currentData->playTime(), UINT32_MAX);
+    score.threeBV = currentData->threeBV();
+    score.timestamp = time(0);
+    ostringstream result;
+    result << "You win! Time: " << fixed << setprecision(3) << score.time / 1000.0 << "s, 3BV: " << score.threeBV << ", 3BV/s: " << setprecision(2) << score.threeBVPerSecond();
+    endGame(result.str());
+    if (leaderboard.qualifies(difficulty, score)) {
+        pendingScore = score;
+        enter(HIGH_SCORE_NAME);
+    }
 }
 
-void MinesweeperGameManager::quit (bool needSave) {
-    if (needSave) {
-        cout << "Save this game? (-1: Cancel, 0: No, 1: Yes): ";
-        int prom;
-        Utils.readInt(prom);
-        if (prom < 0) {
-            startProcess();
-            return;
-        }
-        if (prom == 0) removeRecord(currentData);
-        else save();
-        exportRecords();
-    }
-    cout << "Quitting game" << endl;
-    cout << "Thanks for playing!";
+void MinesweeperGameManager::nameHighScore (const string &command) {
+    MinesweeperDifficulty difficulty {currentData->Width, currentData->Height, currentData->bombsCount};
+    pendingScore.name = command;
+    leaderboard.insert(difficulty, pendingScore);
+    leaderboard.save();
+    enter(END_GAME);
 }
 
-void MinesweeperGameManager::render () {
+void MinesweeperGameManager::renderHighScores () {
     Utils.clearConsole();
-    currentData->render();
+    vector <MinesweeperDifficulty> difficulties = leaderboard.difficulties();
+    if (difficulties.empty()) cout << "NO HIGH SCORES YET" << endl;
+    for (MinesweeperDifficulty &difficulty : difficulties) {
+        cout << "Field size: " << difficulty.height << "x" << difficulty.width << ", Bombs: " << difficulty.bombs << endl;
+        int rank = 0;
+        for (MinesweeperScore &score : leaderboard.top(difficulty)) {
+            cout << "  " << ++rank << ". " << score.name << " | " << fixed << setprecision(3) << score.time / 1000.0 << "s | 3BV: " << score.threeBV << " | 3BV/s: " << setprecision(2) << score.threeBVPerSecond() << endl;
+        }
+    }
+    cout << endl << "Type anything to back to menu: ";
 }
 
-void MinesweeperGameManager::startProcess () {
-    render();
-    cout << "Input row, column position of a block (from 0 to " << currentData->Size - 1 << ") and a flagged number (0 to open, 1 to flag), -1 to exit: ";
-    int row, column, flagged;
-    Utils.readInt(row);
-    if (row < 0) {
-        quit(true);
-        return;
-    }
-    Utils.readInt(column);
-    if (column < 0) {
-        quit(true);
+void MinesweeperGameManager::quit (const string &command) {
+    int prom = toInt(command);
+    if (prom < 0) {
+        enter(PLAYING);
         return;
     }
-    Utils.readInt(flagged);
-    if (flagged < 0) {
-        quit(true);
+    if (prom == 0) removeRecord(currentData);
+    else save();
+    enter(QUITTING);
+}
+
+void MinesweeperGameManager::play (const string &command) {
+    // w/a/s/d only pan a field larger than the viewport, otherwise they go on like any other command
+    if (arguments.empty() && command.length() == 1 && renderer.scrollable() && renderer.pan(command[0])) return;
+    int number = toInt(command);
+    if (number < 0) {
+        enter(SAVE_PROMPT);
         return;
     }
+    arguments.push_back(number);
+    if (arguments.size() < 3) return;
+    int row = arguments[0], column = arguments[1];
+    bool flagged = arguments[2];
+    arguments.clear();
+    renderer.follow(row, column);
     bool hasBomb = currentData->reveal(row, column, false, flagged);
     if (hasBomb) gameOver();
-    else {
-        if (currentData->unrevealedCellsCount == currentData->bombsCount) win();
-        else startProcess();
-    }
+    else if (currentData->unrevealedCellsCount == currentData->bombsCount) win();
+    // the snapshot is the packed board, the metadata and the move log, the worker does the rest
+    else if (autosaveMoves > 0 && ++movesSinceSave >= autosaveMoves) save();
 }
\ No newline at end of file
@@ -0,0 +1,444 @@
+#pragma once
+
+// Log-structured store for the saved games: the records file is a journal of binary records and tombstones
+// Saving appends the new version of one record, deleting appends a tombstone, nothing else is rewritten
+// The last version of every record id that has no tombstone after it is live; a MinesweeperRecordIndex next to the
+// journal lists them with their metadata, so boards are only read when a game is opened
+// Once dead entries (older versions and deleted records) take more than half of the file, a background
+// compaction copies the live records to a temporary file, adds whatever was appended meanwhile, and renames it;
+// the index offsets are moved over by the next call on the journal
+// Reads go through a read-only mapping of the journal, records are decoded straight from it; everything that
+// replaces a file (rewrite, compaction, the index) writes a temporary file, flushes it and renames it over the old one,
+// and every append is flushed before it is indexed
+// put, remove and compactIfNeeded may run on a saving thread while another one lists and opens records;
+// load and rewrite expect no writes in flight
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MineField.h"
+#include "MinesweeperFileSync.h"
+#include "MinesweeperMappedFile.h"
+#include "MinesweeperRecord.h"
+#include "MinesweeperRecordIndex.h"
+
+using namespace std;
+
+class MinesweeperJournal {
+    private:
+
+    string path; // journal file
+
+    string indexPath; // index file, the journal path with the .idx extension
+
+    MinesweeperRecordIndex index; // live records, up to date with the journal once settled
+
+    MinesweeperMappedFile mapped; // mapping of the journal for the reads of the calling thread
+
+    bool mappedStale; // the journal file was replaced, the mapping shows the old one
+
+    mutex fileMutex; // guards the journal file, and the relocation handed over by a finished compaction
+
+    thread compaction; // background compaction, joined before the next one starts
+
+    atomic_bool compacting; // true while the compaction thread runs
+
+    bool relocated; // a compaction swapped the files, index offsets still point into the old journal
+
+    uint64_t relocationEnd; // journal bytes the compaction snapshot covered
+
+    uint64_t relocationSize; // bytes the snapshot took in the new journal
+
+    map <uint64_t, pair <uint64_t, uint32_t>> relocationOffsets; // old offset of every snapshot record -> its new offset and length
+
+    void settle ();
+    // move the index offsets over to a journal swapped by a compaction and save the index, fileMutex held
+
+    uint64_t fileSize ();
+    // size of the journal file, 0 if it is missing
+
+    const uint8_t* mapAt (uint64_t offset, uint64_t length);
+    // the length bytes of the journal at offset, remapping it if needed; nullptr past the end of the file
+
+    bool holds (const MinesweeperRecordInfo &info);
+    // check if the journal has the record described by info at its offset, from the header alone
+
+    bool scan (uint64_t from, uint64_t to, vector <string> &errors, bool &needsCompaction);
+    // catch the index up on the journal entries in [from, to) by their headers, false if damaged bytes were skipped
+    // past a damaged entry the scan resumes at the next intact one, so one bad header doesn't hide the records after it
+
+    uint64_t resync (const uint8_t* journal, uint64_t from, uint64_t to);
+    // offset of the first intact entry (magic, header and checksum) in [from, to) of the mapped journal, to if none
+
+    bool appendBytes (const vector <uint8_t> &bytes, uint64_t &offset);
+    // append bytes at the end of the journal and flush them, offset receives where they start, O(bytes), fileMutex held
+
+    void compact (vector <MinesweeperRecordInfo> live, uint64_t snapshotEnd);
+    // copy the live records (as of snapshotEnd) and the entries appended since to a new journal and swap the files
+    // records without their id in the header (version 1) are written again with it
+
+    public:
+
+    static constexpr double COMPACT_RATIO = 0.5; // dead share of the file that triggers a compaction
+
+    static const size_t COMPACT_MIN_BYTES = 1 << 16; // smaller journals are never worth compacting
+
+    MinesweeperJournal (string path);
+    // constructor, nothing is read until load
+
+    ~MinesweeperJournal ();
+    // waits for a running compaction
+
+    bool exists ();
+    // check if the journal file exists
+
+    void load (vector <string> &errors);
+    // read the index, rebuilding it from the record headers if it is missing or doesn't match the journal
+    // damaged entries are reported in errors; a damaged or id-less journal is compacted right away so appends stay reachable
+
+    vector <MinesweeperRecordInfo> list ();
+    // metadata of the live records, in the order they were first saved
+
+    MineField* open (const MinesweeperRecordInfo &info, string &error);
+    // read and check the board of a listed record, nullptr and error if it is damaged
+
+    bool rewrite (const vector <MineField*> &records);
+    // replace the journal and the index with just records, synchronously, giving ids to records that have none
+
+    uint64_t reserveId ();
+    // id for a record saved for the first time
+
+    bool put (MineField &field);
+    // append the current version of field, giving it an id if it was never saved
+
+    bool remove (uint64_t id);
+    // append a tombstone for record id if it was saved
+
+    void compactIfNeeded ();
+    // start a background compaction if dead entries passed COMPACT_RATIO
+
+    void waitCompaction ();
+    // block until a running compaction has finished and its result is settled
+};
+
+MinesweeperJournal::MinesweeperJournal (string path) {
+    this->path = path;
+    indexPath = path.substr(0, path.rfind('.')) + ".idx";
+    compacting = false;
+    relocated = false;
+    mappedStale = true;
+}
+
+MinesweeperJournal::~MinesweeperJournal () {
+    waitCompaction();
+}
+
+bool MinesweeperJournal::exists () {
+    ifstream file (path, ios::binary);
+    return file.good();
+}
+
+uint64_t MinesweeperJournal::fileSize () {
+    ifstream file (path, ios::binary | ios::ate);
+    return file ? (uint64_t)file.tellg() : 0;
+}
+
+const uint8_t* MinesweeperJournal::mapAt (uint64_t offset, uint64_t length) {
+    if (mappedStale || !mapped.covers(offset, length)) {
+        if (!mapped.open(path)) return nullptr;
+        mappedStale = false;
+    }
+    return mapped.covers(offset, length) ? mapped.data() + offset : nullptr;
+}
+
+bool MinesweeperJournal::holds (const MinesweeperRecordInfo &info) {
+    MinesweeperRecordInfo stored;
+    bool tombstone;
+    string error;
+    uint64_t length = min <uint64_t>(MinesweeperRecord::PEEK_SIZE, info.length);
+    const uint8_t* header = mapAt(info.offset, length);
+    if (header == nullptr || !MinesweeperRecord::peek(header, length, stored, tombstone, error) || tombstone) return false;
+    // version 1 records carry no id, their size has to do
+    return (stored.id == info.id || stored.id == 0) && stored.length == info.length;
+}
+
+bool MinesweeperJournal::scan (uint64_t from, uint64_t to, vector <string> &errors, bool &needsCompaction) {
+    const uint8_t* journal = mapAt(0, to);
+    string error;
+    uint64_t offset = from;
+    bool intact = true;
+    while (offset < to) {
+        MinesweeperRecordInfo info;
+        bool tombstone;
+        error.clear();
+        if (journal == nullptr || !MinesweeperRecord::peek(journal + offset, to - offset, info, tombstone, error) || info.length == 0 || info.length > to - offset) {
+            if (error.empty()) error = "truncated record";
+            uint64_t next = journal == nullptr ? to : resync(journal, offset + 1, to);
+            if (next < to) errors.push_back(path + ", offset " + to_string(offset) + ": " + error + ", " + to_string(next - offset) + " bytes skipped");
+            else errors.push_back(path + ", offset " + to_string(offset) + ": " + error + ", the rest of the file was dropped");
+            // the compaction copies the live records only, the damaged bytes go away with it
+            needsCompaction = true;
+            intact = false;
+            offset = next;
+            continue;
+        }
+        info.offset = offset;
+        if (info.id == 0 && !tombstone) {
+            // version 1 records have no id, the compaction writes them again with the one given here
+            info.id = index.nextId;
+            needsCompaction = true;
+        }
+        index.apply(info, tombstone);
+        offset += info.length;
+    }
+    index.journalBytes = to;
+    return intact;
+}
+
+uint64_t MinesweeperJournal::resync (const uint8_t* journal, uint64_t from, uint64_t to) {
+    for (uint64_t offset = from; offset + 4 <= to; ++offset) {
+        const uint8_t* entry = journal + offset;
+        if (!MinesweeperRecord::isRecord(entry, to - offset) && !MinesweeperRecord::isTombstone(entry, to - offset)) continue;
+        // the magic may just be bytes of a board, only an entry whose checksum holds is trusted, above all a tombstone
+        string error;
+        size_t end = 0;
+        if (MinesweeperRecord::isTombstone(entry, to - offset)) {
+            uint64_t id;
+            if (MinesweeperRecord::readTombstone(entry, to - offset, end, id, error)) return offset;
+            continue;
+        }
+        MineField* field = MinesweeperRecord::read(entry, to - offset, end, error);
+        delete field;
+        // read also steps over records that are intact but not playable
+        if (field != nullptr || end > 0) return offset;
+    }
+    return to;
+}
+
+void MinesweeperJournal::load (vector <string> &errors) {
+    waitCompaction();
+    uint64_t size = fileSize();
+    bool changed = false, needsCompaction = false;
+    {
+        lock_guard <mutex> lock(fileMutex);
+        // a stale index (the journal was compacted or replaced since) fails to find its first or last record in place
+        bool usable = index.read(indexPath) && index.journalBytes <= size;
+        if (usable && !index.entries.empty()) usable = holds(index.entries.begin()->second) && holds(index.entries.rbegin()->second);
+        if (!usable) index.clear();
+        changed = !usable || index.journalBytes < size;
+        scan(index.journalBytes, size, errors, needsCompaction);
+    }
+    if (needsCompaction) {
+        compacting = true;
+        compact(list(), index.journalBytes);
+        waitCompaction();
+    }
+    else if (changed) index.write(indexPath);
+}
+
+vector <MinesweeperRecordInfo> MinesweeperJournal::list () {
+    lock_guard <mutex> lock(fileMutex);
+    settle();
+    vector <MinesweeperRecordInfo> records;
+    for (auto &entry : index.entries) records.push_back(entry.second);
+    return records;
+}
+
+MineField* MinesweeperJournal::open (const MinesweeperRecordInfo &info, string &error) {
+    const uint8_t* record;
+    uint32_t length;
+    {
+        lock_guard <mutex> lock(fileMutex);
+        settle();
+        auto it = index.entries.find(info.id);
+        if (it == index.entries.end()) {
+            error = "record " + to_string(info.id) + " is not in the journal";
+            return nullptr;
+        }
+        length = it->second.length;
+        record = mapAt(it->second.offset, length);
+        if (record == nullptr) {
+            error = path + ", offset " + to_string(it->second.offset) + ": truncated record";
+            return nullptr;
+        }
+    }
+    // the mapping only changes on this thread, so the pages stay valid while the board is decoded from them
+    size_t offset = 0;
+    MineField* field = MinesweeperRecord::read(record, length, offset, error);
+    if (field == nullptr) error = path + ", record " + to_string(info.id) + ": " + error;
+    else field->recordId = info.id;
+    return field;
+}
+
+bool MinesweeperJournal::rewrite (const vector <MineField*> &records) {
+    waitCompaction();
+    lock_guard <mutex> lock(fileMutex);
+    index.clear();
+    // one record at a time through a reused buffer, never the whole journal in memory
+    string temporaryPath = path + ".tmp";
+    ofstream file (temporaryPath, ios::binary | ios::trunc);
+    vector <uint8_t> entry;
+    uint64_t written = 0;
+    for (MineField* field : records) {
+        if (field->recordId == 0) field->recordId = index.nextId;
+        entry.clear();
+        MinesweeperRecord::write(*field, entry);
+        MinesweeperRecordInfo info;
+        bool tombstone;
+        string error;
+        MinesweeperRecord::peek(entry.data(), entry.size(), info, tombstone, error);
+        info.offset = written;
+        index.apply(info, false);
+        file.write((const char*)entry.data(), entry.size());
+        written += entry.size();
+    }
+    file.close();
+    if (!file || !MinesweeperFileSync::replace(temporaryPath, path)) return false;
+    mappedStale = true;
+    index.journalBytes = written;
+    return index.write(indexPath);
+}
+
+bool MinesweeperJournal::appendBytes (const vector <uint8_t> &bytes, uint64_t &offset) {
+    settle();
+    ofstream file (path, ios::binary | ios::app);
+    file.write((const char*)bytes.data(), bytes.size());
+    file.close();
+    // an entry only counts once it is on the disk, a torn one is dropped by the next load
+    if (!file || !MinesweeperFileSync::sync(path)) return false;
+    offset = index.journalBytes;
+    index.journalBytes += bytes.size();
+    return true;
+}
+
+uint64_t MinesweeperJournal::reserveId () {
+    lock_guard <mutex> lock(fileMutex);
+    return index.nextId++;
+}
+
+bool MinesweeperJournal::put (MineField &field) {
+    if (field.recordId == 0) field.recordId = reserveId();
+    // the record is encoded before taking the lock, readers only wait for the write itself
+    vector <uint8_t> entry;
+    MinesweeperRecord::write(field, entry);
+    MinesweeperRecordInfo info;
+    bool tombstone;
+    string error;
+    MinesweeperRecord::peek(entry.data(), entry.size(), info, tombstone, error);
+    lock_guard <mutex> lock(fileMutex);
+    if (!appendBytes(entry, info.offset)) return false;
+    // the index file is not rewritten, the next load catches up on the new entry from its header
+    index.apply(info, false);
+    return true;
+}
+
+bool MinesweeperJournal::remove (uint64_t id) {
+    lock_guard <mutex> lock(fileMutex);
+    if (id == 0 || !index.entries.count(id)) return true;
+    vector <uint8_t> entry;
+    MinesweeperRecord::writeTombstone(id, entry);
+    MinesweeperRecordInfo info;
+    info.id = id;
+    if (!appendBytes(entry, info.offset)) return false;
+    index.apply(info, true);
+    return true;
+}
+
+void MinesweeperJournal::compactIfNeeded () {
+    if (compacting) return;
+    waitCompaction();
+    uint64_t snapshotEnd;
+    {
+        lock_guard <mutex> lock(fileMutex);
+        if (index.journalBytes < COMPACT_MIN_BYTES || index.liveBytes() >= index.journalBytes * (1 - COMPACT_RATIO)) return;
+        snapshotEnd = index.journalBytes;
+    }
+    compacting = true;
+    compaction = thread(&MinesweeperJournal::compact, this, list(), snapshotEnd);
+}
+
+void MinesweeperJournal::compact (vector <MinesweeperRecordInfo> live, uint64_t snapshotEnd) {
+    // everything before snapshotEnd is only ever read, so the copy runs without the lock, from a mapping of its own
+    MinesweeperMappedFile source;
+    source.open(path);
+    string temporaryPath = path + ".tmp";
+    ofstream file (temporaryPath, ios::binary | ios::trunc);
+    vector <uint8_t> entry;
+    uint64_t written = 0;
+    map <uint64_t, pair <uint64_t, uint32_t>> offsets;
+    for (MinesweeperRecordInfo &info : live) {
+        if (!source.covers(info.offset, info.length)) continue;
+        const uint8_t* record = source.data() + info.offset;
+        MinesweeperRecordInfo stored;
+        bool tombstone;
+        string error;
+        MinesweeperRecord::peek(record, info.length, stored, tombstone, error);
+        uint32_t length = info.length;
+        if (stored.id == info.id) file.write((const char*)record, length);
+        else {
+            size_t offset = 0;
+            MineField* field = MinesweeperRecord::read(record, info.length, offset, error);
+            if (field == nullptr) continue;
+            field->recordId = info.id;
+            entry.clear();
+            MinesweeperRecord::write(*field, entry);
+            delete field;
+            file.write((const char*)entry.data(), entry.size());
+            length = entry.size();
+        }
+        offsets[info.offset] = make_pair(written, length);
+        written += length;
+    }
+    {
+        // entries appended after the snapshot still apply on top of it, copy them before swapping the files
+        lock_guard <mutex> lock(fileMutex);
+        uint64_t end = index.journalBytes;
+        if (end > snapshotEnd && source.open(path) && source.covers(snapshotEnd, end - snapshotEnd)) file.write((const char*)source.data() + snapshotEnd, end - snapshotEnd);
+        source.close();
+        file.close();
+        if (file && MinesweeperFileSync::replace(temporaryPath, path)) {
+            relocated = true;
+            relocationEnd = snapshotEnd;
+            relocationSize = written;
+            relocationOffsets = move(offsets);
+        }
+    }
+    compacting = false;
+}
+
+void MinesweeperJournal::settle () {
+    if (!relocated) return;
+    for (auto it = index.entries.begin(); it != index.entries.end();) {
+        MinesweeperRecordInfo &info = it->second;
+        if (info.offset >= relocationEnd) info.offset = info.offset - relocationEnd + relocationSize;
+        else {
+            auto moved = relocationOffsets.find(info.offset);
+            // a record the compaction couldn't read is gone
+            if (moved == relocationOffsets.end()) {
+                it = index.entries.erase(it);
+                continue;
+            }
+            // re-encoded version 1 records changed size
+            info.offset = moved->second.first;
+            info.length = moved->second.second;
+        }
+        ++it;
+    }
+    index.journalBytes = index.journalBytes - relocationEnd + relocationSize;
+    relocated = false;
+    mappedStale = true;
+    relocationOffsets.clear();
+    index.write(indexPath);
+}
+
+void MinesweeperJournal::waitCompaction () {
+    if (compaction.joinable()) compaction.join();
+    lock_guard <mutex> lock(fileMutex);
+    settle();
+}
\ No newline at end of file
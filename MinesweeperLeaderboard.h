@@ -0,0 +1,253 @@
+#pragma once
+
+// High scores: the best capacity results of every difficulty (field size and bombs), fastest first
+// Each table is a heap with its worst kept result on top, so a new result is checked in O(1) and kept in O(log K);
+// nothing but the kept results is ever stored, however many games were won
+// File layout, little-endian, tables in difficulty order and results best first:
+//   header: 0 magic "MSHS" | 4 version (u16) | 6 result size (u16) | 8 capacity (u32) | 12 tables count (u32)
+//           16 results count (u32) | 20 checksum (u32) of the file without it
+//   table:  0 width (u32) | 4 height (u32) | 8 bombs (u32) | 12 results count (u32), then its results
+//   result: 0 time in milliseconds (u32) | 4 3BV (u32) | 8 timestamp (i64) | 16 name (16 bytes, zero-padded)
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "MinesweeperFileSync.h"
+
+using namespace std;
+
+struct MinesweeperDifficulty {
+    int width, height, bombs;
+
+    bool operator< (const MinesweeperDifficulty &other) const;
+};
+
+struct MinesweeperScore {
+    uint32_t time; // completion time in milliseconds, from the first reveal
+
+    uint32_t threeBV; // the fewest reveals that clear the field
+
+    long timestamp; // when the game was won
+
+    string name; // player name, at most NAME_SIZE - 1 bytes are kept
+
+    double threeBVPerSecond () const;
+    // 3BV over the completion time, the speed measure that doesn't depend on how easy the field was
+};
+
+bool MinesweeperDifficulty::operator< (const MinesweeperDifficulty &other) const {
+    return tie(width, height, bombs) < tie(other.width, other.height, other.bombs);
+}
+
+double MinesweeperScore::threeBVPerSecond () const {
+    return threeBV * 1000.0 / max <uint32_t>(time, 1);
+}
+
+class MinesweeperLeaderboard {
+    private:
+
+    string path; // scores file
+
+    map <MinesweeperDifficulty, vector <MinesweeperScore>> tables; // difficulty -> heap of its best results, worst on top
+
+    static bool better (const MinesweeperScore &first, const MinesweeperScore &second);
+    // check if first ranks above second: faster, then more 3BV, then earlier
+
+    static void putU32 (uint8_t* out, uint32_t value);
+
+    static void putU64 (uint8_t* out, uint64_t value);
+
+    static uint32_t getU32 (const uint8_t* in);
+
+    static uint64_t getU64 (const uint8_t* in);
+
+    static uint32_t checksum (const uint8_t* data, size_t size);
+    // checksum of the scores file without its checksum field
+
+    public:
+
+    static const uint32_t MAGIC = 0x5348534D; // "MSHS" read as a little-endian word
+
+    static const uint16_t VERSION = 1;
+
+    static const int HEADER_SIZE = 24;
+
+    static const int TABLE_HEADER_SIZE = 16;
+
+    static const int SCORE_SIZE = 32;
+
+    static const int NAME_SIZE = 16;
+
+    size_t capacity; // results kept per difficulty
+
+    MinesweeperLeaderboard (string path, size_t capacity = 10);
+    // constructor, nothing is read until load
+
+    bool qualifies (const MinesweeperDifficulty &difficulty, const MinesweeperScore &score) const;
+    // check if score would be kept, O(log difficulties)
+
+    bool insert (const MinesweeperDifficulty &difficulty, const MinesweeperScore &score);
+    // keep score if it is among the best of its difficulty, O(log K); false if it wasn't kept
+
+    vector <MinesweeperScore> top (const MinesweeperDifficulty &difficulty) const;
+    // kept results of a difficulty, best first
+
+    vector <MinesweeperDifficulty> difficulties () const;
+    // difficulties with results, smallest fields first
+
+    bool load ();
+    // read the scores file, false (and no scores) if it is missing or damaged
+
+    bool save () const;
+    // write the scores file through a flushed temporary file and a rename
+};
+
+MinesweeperLeaderboard::MinesweeperLeaderboard (string path, size_t capacity) {
+    this->path = path;
+    this->capacity = max <size_t>(capacity, 1);
+}
+
+bool MinesweeperLeaderboard::better (const MinesweeperScore &first, const MinesweeperScore &second) {
+    if (first.time != second.time) return first.time < second.time;
+    if (first.threeBV != second.threeBV) return first.threeBV > second.threeBV;
+    return first.timestamp < second.timestamp;
+}
+
+void MinesweeperLeaderboard::putU32 (uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+void MinesweeperLeaderboard::putU64 (uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+uint32_t MinesweeperLeaderboard::getU32 (const uint8_t* in) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) value = (value << 8) | in[i];
+    return value;
+}
+
+uint64_t MinesweeperLeaderboard::getU64 (const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) value = (value << 8) | in[i];
+    return value;
+}
+
+uint32_t MinesweeperLeaderboard::checksum (const uint8_t* data, size_t size) {
+    // FNV-1a over everything but the checksum field, the file is small
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        if (i >= 20 && i < 24) continue;
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+bool MinesweeperLeaderboard::qualifies (const MinesweeperDifficulty &difficulty, const MinesweeperScore &score) const {
+    auto it = tables.find(difficulty);
+    return it == tables.end() || it->second.size() < capacity || better(score, it->second.front());
+}
+
+bool MinesweeperLeaderboard::insert (const MinesweeperDifficulty &difficulty, const MinesweeperScore &score) {
+    vector <MinesweeperScore> &table = tables[difficulty];
+    if (table.size() < capacity) {
+        table.push_back(score);
+        table.back().name.resize(min <size_t>(score.name.size(), NAME_SIZE - 1));
+        push_heap(table.begin(), table.end(), better);
+        return true;
+    }
+    if (!better(score, table.front())) return false;
+    // drop the worst kept result, the new one takes its slot
+    pop_heap(table.begin(), table.end(), better);
+    table.back() = score;
+    table.back().name.resize(min <size_t>(score.name.size(), NAME_SIZE - 1));
+    push_heap(table.begin(), table.end(), better);
+    return true;
+}
+
+vector <MinesweeperScore> MinesweeperLeaderboard::top (const MinesweeperDifficulty &difficulty) const {
+    auto it = tables.find(difficulty);
+    if (it == tables.end()) return {};
+    vector <MinesweeperScore> scores = it->second;
+    sort_heap(scores.begin(), scores.end(), better);
+    return scores;
+}
+
+vector <MinesweeperDifficulty> MinesweeperLeaderboard::difficulties () const {
+    vector <MinesweeperDifficulty> result;
+    for (auto &table : tables) result.push_back(table.first);
+    return result;
+}
+
+bool MinesweeperLeaderboard::load () {
+    tables.clear();
+    ifstream file (path, ios::binary);
+    if (!file) return false;
+    vector <uint8_t> content( (istreambuf_iterator<char>(file) ), (istreambuf_iterator<char>()    ) );
+    if (content.size() < HEADER_SIZE || getU32(content.data()) != MAGIC || (content[4] | (content[5] << 8)) != VERSION || (content[6] | (content[7] << 8)) != SCORE_SIZE) return false;
+    uint32_t tablesCount = getU32(content.data() + 12), scoresCount = getU32(content.data() + 16);
+    if (content.size() != HEADER_SIZE + (size_t)tablesCount * TABLE_HEADER_SIZE + (size_t)scoresCount * SCORE_SIZE || checksum(content.data(), content.size()) != getU32(content.data() + 20)) return false;
+    const uint8_t* cursor = content.data() + HEADER_SIZE, *end = content.data() + content.size();
+    for (uint32_t i = 0; i < tablesCount; ++i) {
+        if (end - cursor < TABLE_HEADER_SIZE) break;
+        MinesweeperDifficulty difficulty {(int)getU32(cursor), (int)getU32(cursor + 4), (int)getU32(cursor + 8)};
+        uint32_t count = getU32(cursor + 12);
+        cursor += TABLE_HEADER_SIZE;
+        if ((size_t)(end - cursor) < (size_t)count * SCORE_SIZE) break;
+        // the file lists the results best first, a smaller capacity keeps the front
+        vector <MinesweeperScore> &table = tables[difficulty];
+        for (uint32_t j = 0; j < count; ++j, cursor += SCORE_SIZE) {
+            if (table.size() == capacity) continue;
+            MinesweeperScore score;
+            score.time = getU32(cursor);
+            score.threeBV = getU32(cursor + 4);
+            score.timestamp = (long)getU64(cursor + 8);
+            const char* name = (const char*)cursor + 16;
+            score.name.assign(name, find(name, name + NAME_SIZE - 1, '\0'));
+            table.push_back(score);
+        }
+        make_heap(table.begin(), table.end(), better);
+    }
+    return true;
+}
+
+bool MinesweeperLeaderboard::save () const {
+    size_t scoresCount = 0;
+    for (auto &table : tables) scoresCount += table.second.size();
+    vector <uint8_t> content(HEADER_SIZE + tables.size() * TABLE_HEADER_SIZE + scoresCount * SCORE_SIZE, 0);
+    putU32(content.data(), MAGIC);
+    content[4] = VERSION & 0xFF;
+    content[5] = VERSION >> 8;
+    content[6] = SCORE_SIZE & 0xFF;
+    content[7] = SCORE_SIZE >> 8;
+    putU32(content.data() + 8, capacity);
+    putU32(content.data() + 12, tables.size());
+    putU32(content.data() + 16, scoresCount);
+    uint8_t* cursor = content.data() + HEADER_SIZE;
+    for (auto &table : tables) {
+        putU32(cursor, table.first.width);
+        putU32(cursor + 4, table.first.height);
+        putU32(cursor + 8, table.first.bombs);
+        putU32(cursor + 12, table.second.size());
+        cursor += TABLE_HEADER_SIZE;
+        for (const MinesweeperScore &score : top(table.first)) {
+            putU32(cursor, score.time);
+            putU32(cursor + 4, score.threeBV);
+            putU64(cursor + 8, (uint64_t)score.timestamp);
+            copy(score.name.begin(), score.name.end(), cursor + 16);
+            cursor += SCORE_SIZE;
+        }
+    }
+    putU32(content.data() + 20, checksum(content.data(), content.size()));
+    string temporaryPath = path + ".tmp";
+    ofstream file (temporaryPath, ios::binary | ios::trunc);
+    file.write((const char*)content.data(), content.size());
+    file.close();
+    return file && MinesweeperFileSync::replace(temporaryPath, path);
+}
\ No newline at end of file
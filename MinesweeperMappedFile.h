@@ -0,0 +1,145 @@
+#pragma once
+
+// Read-only memory mapping of a whole file: records are decoded straight from the mapped pages,
+// so reading a saved board costs the board itself and no copy of the file
+// The mapping is a snapshot of the file as opened: bytes appended later need a remap, and a file replaced
+// by a rename keeps showing its old contents until then
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+class MinesweeperMappedFile {
+    private:
+
+    const uint8_t* bytes; // first mapped byte, nullptr for an empty or closed file
+
+    size_t length; // number of mapped bytes
+
+    public:
+
+    MinesweeperMappedFile ();
+
+    ~MinesweeperMappedFile ();
+    // unmaps the file
+
+    MinesweeperMappedFile (const MinesweeperMappedFile&) = delete;
+
+    MinesweeperMappedFile& operator= (const MinesweeperMappedFile&) = delete;
+
+    bool open (const string &path);
+    // map the file at path, replacing the current mapping; false if it can't be opened (an empty file maps fine)
+
+    void close ();
+    // unmap the file
+
+    const uint8_t* data () const;
+
+    size_t size () const;
+
+    bool covers (uint64_t offset, uint64_t count) const;
+    // check if the count bytes at offset are mapped
+
+    string_view text () const;
+    // the whole mapping as text
+};
+
+MinesweeperMappedFile::MinesweeperMappedFile () {
+    bytes = nullptr;
+    length = 0;
+}
+
+MinesweeperMappedFile::~MinesweeperMappedFile () {
+    close();
+}
+
+bool MinesweeperMappedFile::open (const string &path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return false;
+    }
+    if (fileSize.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        // the view keeps the mapping alive on its own
+        if (mapping != nullptr) {
+            bytes = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        if (bytes == nullptr) {
+            CloseHandle(file);
+            return false;
+        }
+        length = fileSize.QuadPart;
+    }
+    CloseHandle(file);
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) return false;
+    struct stat status;
+    if (fstat(file, &status) != 0) {
+        ::close(file);
+        return false;
+    }
+    if (status.st_size > 0) {
+        void* mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapping == MAP_FAILED) {
+            ::close(file);
+            return false;
+        }
+        // records are read front to back
+        madvise(mapping, status.st_size, MADV_SEQUENTIAL);
+        bytes = (const uint8_t*)mapping;
+        length = status.st_size;
+    }
+    // the mapping keeps the file alive on its own
+    ::close(file);
+#endif
+    return true;
+}
+
+void MinesweeperMappedFile::close () {
+    if (bytes != nullptr) {
+#ifdef _WIN32
+        UnmapViewOfFile(bytes);
+#else
+        munmap((void*)bytes, length);
+#endif
+    }
+    bytes = nullptr;
+    length = 0;
+}
+
+const uint8_t* MinesweeperMappedFile::data () const {
+    return bytes;
+}
+
+size_t MinesweeperMappedFile::size () const {
+    return length;
+}
+
+bool MinesweeperMappedFile::covers (uint64_t offset, uint64_t count) const {
+    return offset <= length && count <= length - offset;
+}
+
+string_view MinesweeperMappedFile::text () const {
+    return string_view((const char*)bytes, length);
+}
\ No newline at end of file
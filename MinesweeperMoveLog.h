@@ -0,0 +1,93 @@
+#pragma once
+
+// Compact log of the moves played on a field, in the order they were played
+// Each move is two varints (7 bits per byte, low bits first): (logical cell index * 2 + flag) then the
+// milliseconds since the previous move, so a move usually takes 3 to 5 bytes
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+struct MinesweeperMove {
+    int cell; // logical index (x * width + y) of the cell
+
+    bool flag; // the cell was flagged or unflagged, revealed otherwise
+
+    uint32_t delay; // milliseconds since the previous move
+};
+
+class MinesweeperMoveLog {
+    public:
+
+    vector <uint8_t> bytes; // encoded moves
+
+    uint32_t count; // number of moves in bytes
+
+    bool complete; // the log starts from the empty board, so replaying it rebuilds the field
+
+    MinesweeperMoveLog ();
+    // constructor, creates the empty log of a new field
+
+    void clear (bool complete);
+    // drop every move, complete tells if the field has no move played yet
+
+    void append (int cell, bool flag, uint32_t delay);
+    // log a move
+
+    bool next (size_t &cursor, MinesweeperMove &move) const;
+    // decode the move at bytes[cursor] and move cursor past it, false at the end of the log or if it is damaged
+
+    static void putVarint (vector <uint8_t> &out, uint32_t value);
+    // append value 7 bits at a time, low bits first
+
+    static bool getVarint (const uint8_t* in, size_t size, size_t &offset, uint32_t &value);
+    // read the varint at in[offset] and move offset past it, false if it runs past size
+};
+
+MinesweeperMoveLog::MinesweeperMoveLog () {
+    clear(true);
+}
+
+void MinesweeperMoveLog::clear (bool complete) {
+    bytes.clear();
+    count = 0;
+    this->complete = complete;
+}
+
+void MinesweeperMoveLog::append (int cell, bool flag, uint32_t delay) {
+    putVarint(bytes, ((uint32_t)cell << 1) | flag);
+    putVarint(bytes, delay);
+    ++count;
+}
+
+bool MinesweeperMoveLog::next (size_t &cursor, MinesweeperMove &move) const {
+    uint32_t action;
+    if (!getVarint(bytes.data(), bytes.size(), cursor, action) || !getVarint(bytes.data(), bytes.size(), cursor, move.delay)) return false;
+    move.cell = action >> 1;
+    move.flag = action & 1;
+    return true;
+}
+
+void MinesweeperMoveLog::putVarint (vector <uint8_t> &out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+bool MinesweeperMoveLog::getVarint (const uint8_t* in, size_t size, size_t &offset, uint32_t &value) {
+    // one-byte values (most delays and small boards) skip the loop
+    if (offset < size && in[offset] < 0x80) {
+        value = in[offset++];
+        return true;
+    }
+    value = 0;
+    for (int shift = 0; shift < 35 && offset < size; shift += 7) {
+        uint8_t byte = in[offset++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,496 @@
+#pragma once
+
+// Exact mine probability of every hidden cell of a MineField, from its visible state (flags are taken as mines)
+// The hidden cells next to a revealed number form the frontier; numbers sharing cells link them into components that
+// only depend on each other through the total mines count. Cells touched by exactly the same numbers form a group,
+// so a group of n cells is one choice of 0..n mines weighing binomial(n, mines) instead of 2^n choices
+// Each component is enumerated by backtracking over its groups, counting its solutions and the mines of every group
+// by mines used; the components and the interior cells (hidden, next to no number) are then combined with the mines
+// left, a way to place k frontier mines weighing binomial(interior cells, mines left - k)
+// Components with many groups are split on the choices of their first groups into tasks for MinesweeperWorkPool
+// A component whose search exceeds NODE_BUDGET nodes gets approximate probabilities instead (the mean mine density
+// of the numbers around each cell), approximatedComponents reports it
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "MineField.h"
+#include "MinesweeperWorkPool.h"
+
+using namespace std;
+
+class MinesweeperProbability {
+    private:
+
+    struct Component {
+        vector <int> groupSizes; // cells of each group, groups in search order
+
+        vector <vector <int>> groupCells; // board indices of the cells of each group
+
+        vector <vector <int>> groupConstraints; // local numbers around each group
+
+        vector <int> values; // mines left around each local number
+
+        vector <int> constraintSizes; // frontier cells around each local number
+
+        int cellsCount; // frontier cells of the component
+
+        vector <double> solutions; // mines k -> weighted count of the solutions placing k mines
+
+        vector <double> groupMines; // k * groups + g -> weighted count of the mines of group g over those solutions
+    };
+
+    struct Search {
+        const Component* component;
+
+        vector <int> sums; // mines placed around each number
+
+        vector <int> rests; // cells left undecided around each number
+
+        vector <uint8_t> chosen; // mines chosen for each decided group
+
+        vector <double> solutions; // like Component::solutions, for this task only
+
+        vector <double> groupMines; // like Component::groupMines, for this task only
+
+        vector <vector <uint8_t>>* prefixes; // receives the choices of the first stopDepth groups when splitting
+
+        int stopDepth; // groups decided before the search stops, the group count to enumerate everything
+
+        uint64_t nodes; // groups tried
+
+        uint64_t budget; // nodes this task may try, its share of NODE_BUDGET
+
+        atomic_bool* aborted; // set once a task of the component runs out of budget
+
+        bool assign (int group, int mines);
+        // add mines to the numbers around group, false if one of them can't be satisfied any more
+
+        void unassign (int group, int mines);
+        // undo assign
+
+        void run (int group, double weight, int mines);
+        // enumerate every choice of the groups from group on
+    };
+
+    MineField &field; // field the probabilities are computed for
+
+    vector <Component> components;
+
+    vector <int> interior; // board indices of the hidden cells next to no number
+
+    static double binomial (int n, int k);
+    // n choose k, as a double
+
+    static double logBinomial (int n, int k);
+    // natural logarithm of n choose k
+
+    static vector <double> convolve (const vector <double> &first, const vector <double> &second);
+    // distribution of the sum of two independent mines counts, scaled so its largest term is 1
+
+    bool build ();
+    // read the visible field into components and interior, false if a number can't be satisfied
+
+    void enumerate ();
+    // count the solutions of every component, splitting the large ones across the pool
+
+    void approximate (Component &component);
+    // fill the probabilities of component with the mean density of the numbers around each group
+
+    bool combine (int minesLeft);
+    // weigh the components with the mines left and fill probabilities, false if no placement is possible
+
+    public:
+
+    static const uint64_t NODE_BUDGET = 1 << 21; // search nodes per component before falling back to approximation
+
+    static const int SPLIT_GROUPS = 24; // components with at least this many groups are split across threads
+
+    int threadsCount; // threads for the large components, 0 for every hardware thread
+
+    vector <double> probabilities; // board index -> chance of a mine: 0 for revealed cells, 1 for flagged ones, -1 if unknown
+
+    double interiorProbability; // chance of a mine for each hidden cell next to no number
+
+    int frontierCells; // hidden cells next to a number
+
+    int interiorCells; // hidden cells next to no number
+
+    int largestComponent; // frontier cells of the largest component
+
+    int approximatedComponents; // components that fell back to approximation in the last compute
+
+    uint64_t nodes; // search nodes of the last compute
+
+    double milliseconds; // duration of the last compute
+
+    MinesweeperProbability (MineField &field, int threadsCount = 0);
+    // constructor
+
+    bool compute ();
+    // compute every probability, false if the visible field has no solution (a wrong flag)
+
+    int safestCell () const;
+    // board index of the hidden unflagged cell least likely to be a mine, -1 if there is none
+};
+
+MinesweeperProbability::MinesweeperProbability (MineField &field, int threadsCount) : field(field) {
+    this->threadsCount = threadsCount;
+    interiorProbability = 0;
+    frontierCells = interiorCells = largestComponent = approximatedComponents = 0;
+    nodes = 0;
+    milliseconds = 0;
+}
+
+double MinesweeperProbability::binomial (int n, int k) {
+    double result = 1;
+    for (int i = 1; i <= k; ++i) result = result * (n - k + i) / i;
+    return result;
+}
+
+double MinesweeperProbability::logBinomial (int n, int k) {
+    return lgamma(n + 1.0) - lgamma(k + 1.0) - lgamma(n - k + 1.0);
+}
+
+vector <double> MinesweeperProbability::convolve (const vector <double> &first, const vector <double> &second) {
+    vector <double> result(first.size() + second.size() - 1, 0);
+    for (size_t i = 0; i < first.size(); ++i) {
+        if (first[i] == 0) continue;
+        for (size_t j = 0; j < second.size(); ++j) result[i + j] += first[i] * second[j];
+    }
+    // only ratios matter, rescaling keeps long products of huge counts finite
+    double largest = *max_element(result.begin(), result.end());
+    if (largest > 0) {
+        for (double &value : result) value /= largest;
+    }
+    return result;
+}
+
+bool MinesweeperProbability::Search::assign (int group, int mines) {
+    bool feasible = true;
+    int size = component->groupSizes[group];
+    for (int constraint : component->groupConstraints[group]) {
+        sums[constraint] += mines;
+        rests[constraint] -= size;
+        feasible &= sums[constraint] <= component->values[constraint] && sums[constraint] + rests[constraint] >= component->values[constraint];
+    }
+    return feasible;
+}
+
+void MinesweeperProbability::Search::unassign (int group, int mines) {
+    int size = component->groupSizes[group];
+    for (int constraint : component->groupConstraints[group]) {
+        sums[constraint] -= mines;
+        rests[constraint] += size;
+    }
+}
+
+void MinesweeperProbability::Search::run (int group, double weight, int mines) {
+    if (++nodes > budget || *aborted) {
+        *aborted = true;
+        return;
+    }
+    int groupsCount = component->groupSizes.size();
+    if (group == stopDepth && stopDepth < groupsCount) {
+        prefixes->emplace_back(chosen.begin(), chosen.begin() + group);
+        return;
+    }
+    if (group == groupsCount) {
+        solutions[mines] += weight;
+        double* counts = groupMines.data() + (size_t)mines * groupsCount;
+        for (int g = 0; g < groupsCount; ++g) counts[g] += weight * chosen[g];
+        return;
+    }
+    int size = component->groupSizes[group];
+    for (int m = 0; m <= size; ++m) {
+        if (assign(group, m)) {
+            chosen[group] = m;
+            run(group + 1, weight * binomial(size, m), mines + m);
+        }
+        unassign(group, m);
+    }
+}
+
+bool MinesweeperProbability::build () {
+    DynamicBoard &board = field.board;
+    const array <int, 8> &offsets = board.neighborOffsets();
+    auto hidden = [&](int index) { return !MineCell::revealed(board[index]) && !MineCell::flagged(board[index]); };
+    components.clear();
+    // numbers with hidden neighbors, in board order
+    vector <int> constraintCells, values, constraintOf(board.paddedSize(), -1);
+    for (int x = 0; x < field.Height; ++x) {
+        for (int index = board.index(x, 0), end = index + field.Width; index < end; ++index) {
+            CellState cell = board[index];
+            if (!MineCell::revealed(cell) || MineCell::hasBomb(cell)) continue;
+            int value = MineCell::neighborBombsCount(cell), unknown = 0;
+            for (int offset : offsets) {
+                value -= MineCell::flagged(board[index + offset]);
+                unknown += hidden(index + offset);
+            }
+            if (value < 0 || value > unknown) return false;
+            if (unknown == 0) continue;
+            constraintOf[index] = constraintCells.size();
+            constraintCells.push_back(index);
+            values.push_back(value);
+        }
+    }
+    // numbers sharing a hidden cell belong to the same component
+    vector <int> parent(constraintCells.size());
+    for (size_t i = 0; i < parent.size(); ++i) parent[i] = i;
+    auto root = [&](int constraint) {
+        while (parent[constraint] != constraint) constraint = parent[constraint] = parent[parent[constraint]];
+        return constraint;
+    };
+    // hidden cells touched by the same numbers share a group
+    map <vector <int>, int> groupOf;
+    vector <vector <int>> groupCells, groupConstraints;
+    interior.clear();
+    frontierCells = 0;
+    for (int x = 0; x < field.Height; ++x) {
+        for (int index = board.index(x, 0), end = index + field.Width; index < end; ++index) {
+            if (!hidden(index)) continue;
+            vector <int> around;
+            for (int offset : offsets) {
+                if (constraintOf[index + offset] >= 0) around.push_back(constraintOf[index + offset]);
+            }
+            if (around.empty()) {
+                interior.push_back(index);
+                continue;
+            }
+            ++frontierCells;
+            sort(around.begin(), around.end());
+            for (int constraint : around) parent[root(constraint)] = root(around[0]);
+            auto inserted = groupOf.emplace(around, groupCells.size());
+            if (inserted.second) {
+                groupCells.emplace_back();
+                groupConstraints.push_back(around);
+            }
+            groupCells[inserted.first->second].push_back(index);
+        }
+    }
+    // split the groups by component, then order each component's groups breadth-first through its numbers,
+    // so every number is closed (and checked exactly) as early as possible
+    map <int, int> componentOf;
+    vector <vector <int>> componentGroups;
+    for (size_t g = 0; g < groupCells.size(); ++g) {
+        auto inserted = componentOf.emplace(root(groupConstraints[g][0]), componentGroups.size());
+        if (inserted.second) componentGroups.emplace_back();
+        componentGroups[inserted.first->second].push_back(g);
+    }
+    vector <vector <int>> constraintGroups(constraintCells.size());
+    for (size_t g = 0; g < groupCells.size(); ++g) {
+        for (int constraint : groupConstraints[g]) constraintGroups[constraint].push_back(g);
+    }
+    vector <int> localGroup(groupCells.size(), -1), localConstraint(constraintCells.size(), -1);
+    interiorCells = interior.size();
+    largestComponent = 0;
+    for (vector <int> &groups : componentGroups) {
+        Component component;
+        component.cellsCount = 0;
+        vector <int> order {groups[0]};
+        localGroup[groups[0]] = 0;
+        for (size_t i = 0; i < order.size(); ++i) {
+            for (int constraint : groupConstraints[order[i]]) {
+                if (localConstraint[constraint] < 0) {
+                    localConstraint[constraint] = component.values.size();
+                    component.values.push_back(values[constraint]);
+                    component.constraintSizes.push_back(0);
+                }
+                for (int next : constraintGroups[constraint]) {
+                    if (localGroup[next] >= 0) continue;
+                    localGroup[next] = order.size();
+                    order.push_back(next);
+                }
+            }
+        }
+        for (int g : order) {
+            component.groupSizes.push_back(groupCells[g].size());
+            component.groupCells.push_back(groupCells[g]);
+            component.groupConstraints.emplace_back();
+            for (int constraint : groupConstraints[g]) {
+                component.groupConstraints.back().push_back(localConstraint[constraint]);
+                component.constraintSizes[localConstraint[constraint]] += groupCells[g].size();
+            }
+            component.cellsCount += groupCells[g].size();
+        }
+        largestComponent = max(largestComponent, component.cellsCount);
+        components.push_back(move(component));
+    }
+    return true;
+}
+
+void MinesweeperProbability::approximate (Component &component) {
+    int groupsCount = component.groupSizes.size();
+    // one pseudo-solution holding the expected mines of every group
+    vector <double> expected(groupsCount, 0);
+    double total = 0;
+    for (int g = 0; g < groupsCount; ++g) {
+        for (int constraint : component.groupConstraints[g]) expected[g] += (double)component.values[constraint] / component.constraintSizes[constraint];
+        expected[g] *= (double)component.groupSizes[g] / component.groupConstraints[g].size();
+        total += expected[g];
+    }
+    int mines = min((int)lround(total), component.cellsCount);
+    component.solutions.assign(component.cellsCount + 1, 0);
+    component.solutions[mines] = 1;
+    component.groupMines.assign((size_t)(component.cellsCount + 1) * groupsCount, 0);
+    copy(expected.begin(), expected.end(), component.groupMines.begin() + (size_t)mines * groupsCount);
+}
+
+bool MinesweeperProbability::combine (int minesLeft) {
+    size_t count = components.size();
+    // prefix[i] and suffix[i]: mines distributions of the components before i and from i on
+    vector <vector <double>> prefix(count + 1, vector <double>(1, 1)), suffix(count + 1, vector <double>(1, 1));
+    for (size_t i = 0; i < count; ++i) prefix[i + 1] = convolve(prefix[i], components[i].solutions);
+    for (size_t i = count; i-- > 0;) suffix[i] = convolve(components[i].solutions, suffix[i + 1]);
+    // weight of s frontier mines: the ways to place the others among the interior cells, relative to the largest
+    vector <double> weights(prefix[count].size(), 0);
+    double largest = -INFINITY;
+    for (size_t s = 0; s < weights.size(); ++s) {
+        int rest = minesLeft - (int)s;
+        weights[s] = rest < 0 || rest > interiorCells ? -INFINITY : logBinomial(interiorCells, rest);
+        largest = max(largest, weights[s]);
+    }
+    if (largest == -INFINITY) return false;
+    for (double &weight : weights) weight = exp(weight - largest);
+    double total = 0, interiorMines = 0;
+    for (size_t s = 0; s < weights.size(); ++s) {
+        total += prefix[count][s] * weights[s];
+        interiorMines += prefix[count][s] * weights[s] * (minesLeft - (int)s);
+    }
+    if (total == 0) return false;
+    interiorProbability = interiorCells == 0 ? 0 : interiorMines / total / interiorCells;
+    for (int index : interior) probabilities[index] = interiorProbability;
+    for (size_t i = 0; i < count; ++i) {
+        Component &component = components[i];
+        int groupsCount = component.groupSizes.size();
+        vector <double> others = convolve(prefix[i], suffix[i + 1]);
+        // weight of the solutions of this component placing k mines, given every way to complete them
+        double componentTotal = 0;
+        vector <double> groupTotals(groupsCount, 0);
+        for (size_t k = 0; k < component.solutions.size(); ++k) {
+            double weight = 0;
+            for (size_t s = 0; s < others.size() && k + s < weights.size(); ++s) weight += others[s] * weights[k + s];
+            if (weight == 0) continue;
+            componentTotal += component.solutions[k] * weight;
+            for (int g = 0; g < groupsCount; ++g) groupTotals[g] += component.groupMines[k * groupsCount + g] * weight;
+        }
+        if (componentTotal == 0) return false;
+        for (int g = 0; g < groupsCount; ++g) {
+            double probability = min(groupTotals[g] / componentTotal / component.groupSizes[g], 1.0);
+            for (int index : component.groupCells[g]) probabilities[index] = probability;
+        }
+    }
+    return true;
+}
+
+void MinesweeperProbability::enumerate () {
+    // small components are one task each, large ones one task per feasible choice of their first groups
+    MinesweeperWorkPool pool(threadsCount);
+    vector <pair <int, vector <uint8_t>>> tasks;
+    unique_ptr <atomic_bool[]> aborted(new atomic_bool[components.size()]);
+    bool split = false;
+    for (size_t c = 0; c < components.size(); ++c) {
+        Component &component = components[c];
+        int groupsCount = component.groupSizes.size();
+        aborted[c] = false;
+        component.solutions.assign(component.cellsCount + 1, 0);
+        component.groupMines.assign((size_t)(component.cellsCount + 1) * groupsCount, 0);
+        if (groupsCount < SPLIT_GROUPS || pool.threadsCount == 1) {
+            tasks.emplace_back(c, vector <uint8_t>());
+            continue;
+        }
+        split = true;
+        int depth = 0;
+        for (double choices = 1; depth < groupsCount / 2 && choices < 8 * pool.threadsCount; ++depth) choices *= component.groupSizes[depth] + 1;
+        vector <vector <uint8_t>> prefixes;
+        Search search {&component, vector <int>(component.values.size(), 0), component.constraintSizes, vector <uint8_t>(groupsCount, 0), {}, {}, &prefixes, depth, 0, NODE_BUDGET, &aborted[c]};
+        search.run(0, 1, 0);
+        nodes += search.nodes;
+        for (vector <uint8_t> &prefix : prefixes) tasks.emplace_back(c, move(prefix));
+    }
+    // without a large component, threads would cost more than they save
+    if (!split) pool.threadsCount = 1;
+    // the budget of a component is shared by its tasks, so the fallback doesn't depend on the threads count
+    vector <uint64_t> tasksCount(components.size(), 0);
+    for (auto &task : tasks) ++tasksCount[task.first];
+    vector <Search> results(tasks.size());
+    pool.run(tasks.size(), [&](int, size_t t) {
+        int c = tasks[t].first;
+        Component &component = components[c];
+        int groupsCount = component.groupSizes.size();
+        Search &search = results[t];
+        search = {&component, vector <int>(component.values.size(), 0), component.constraintSizes, vector <uint8_t>(groupsCount, 0), vector <double>(component.cellsCount + 1, 0), vector <double>((size_t)(component.cellsCount + 1) * groupsCount, 0), nullptr, groupsCount, 0, max <uint64_t>(NODE_BUDGET / tasksCount[c], 1), &aborted[c]};
+        // replay the choices the task was split on, they are known to be feasible
+        const vector <uint8_t> &prefix = tasks[t].second;
+        double weight = 1;
+        int mines = 0;
+        for (size_t g = 0; g < prefix.size(); ++g) {
+            search.assign(g, prefix[g]);
+            search.chosen[g] = prefix[g];
+            weight *= binomial(component.groupSizes[g], prefix[g]);
+            mines += prefix[g];
+        }
+        search.run(prefix.size(), weight, mines);
+    });
+    for (size_t t = 0; t < tasks.size(); ++t) {
+        Component &component = components[tasks[t].first];
+        nodes += results[t].nodes;
+        for (size_t k = 0; k < component.solutions.size(); ++k) component.solutions[k] += results[t].solutions[k];
+        for (size_t i = 0; i < component.groupMines.size(); ++i) component.groupMines[i] += results[t].groupMines[i];
+    }
+    for (size_t c = 0; c < components.size(); ++c) {
+        if (!aborted[c]) continue;
+        approximate(components[c]);
+        ++approximatedComponents;
+    }
+}
+
+bool MinesweeperProbability::compute () {
+    auto start = chrono::steady_clock::now();
+    DynamicBoard &board = field.board;
+    probabilities.assign(board.paddedSize(), 0);
+    nodes = 0;
+    approximatedComponents = 0;
+    int minesLeft = field.bombsCount;
+    for (int x = 0; x < field.Height; ++x) {
+        for (int index = board.index(x, 0), end = index + field.Width; index < end; ++index) {
+            if (!MineCell::flagged(board[index])) continue;
+            probabilities[index] = 1;
+            --minesLeft;
+        }
+    }
+    bool consistent = build();
+    if (consistent) {
+        enumerate();
+        consistent = combine(minesLeft);
+    }
+    if (!consistent) {
+        // nothing can be told about the hidden cells of an impossible field
+        for (int x = 0; x < field.Height; ++x) {
+            for (int index = board.index(x, 0), end = index + field.Width; index < end; ++index) {
+                if (!MineCell::revealed(board[index]) && !MineCell::flagged(board[index])) probabilities[index] = -1;
+            }
+        }
+    }
+    milliseconds = chrono::duration <double, milli>(chrono::steady_clock::now() - start).count();
+    return consistent;
+}
+
+int MinesweeperProbability::safestCell () const {
+    DynamicBoard &board = field.board;
+    int best = -1;
+    for (int x = 0; x < field.Height; ++x) {
+        for (int index = board.index(x, 0), end = index + field.Width; index < end; ++index) {
+            CellState cell = board[index];
+            if (MineCell::revealed(cell) || MineCell::flagged(cell) || probabilities[index] < 0) continue;
+            if (best < 0 || probabilities[index] < probabilities[best]) best = index;
+        }
+    }
+    return best;
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+// Small, fast random engine (xoshiro256**), usable anywhere a standard URBG is expected
+
+#include <cstdint>
+
+class MinesweeperRandom {
+    private:
+
+    uint64_t state[4];
+
+    static uint64_t rotl (uint64_t value, int bits);
+    // rotate value left by bits
+
+    public:
+
+    typedef uint64_t result_type;
+
+    MinesweeperRandom (uint64_t seed);
+    // constructor, expands the seed into the engine state with splitmix64
+
+    void seed (uint64_t seed);
+    // reset the engine state from seed
+
+    uint64_t operator() ();
+    // next 64-bit output
+
+    uint32_t below (uint32_t bound);
+    // unbiased random integer in [0, bound), Lemire's multiply-shift method
+
+    static constexpr uint64_t min () { return 0; }
+
+    static constexpr uint64_t max () { return UINT64_MAX; }
+};
+
+MinesweeperRandom::MinesweeperRandom (uint64_t seed) {
+    this->seed(seed);
+}
+
+uint64_t MinesweeperRandom::rotl (uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+void MinesweeperRandom::seed (uint64_t seed) {
+    for (uint64_t &word : state) {
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        word = z ^ (z >> 31);
+    }
+}
+
+uint64_t MinesweeperRandom::operator() () {
+    uint64_t result = rotl(state[1] * 5, 7) * 9;
+    uint64_t t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 45);
+    return result;
+}
+
+uint32_t MinesweeperRandom::below (uint32_t bound) {
+    if (bound <= 1) return 0;
+    uint64_t product = ((*this)() >> 32) * bound;
+    if ((uint32_t)product < bound) {
+        // only draws in the low rejection zone need the division
+        uint32_t threshold = -bound % bound;
+        while ((uint32_t)product < threshold) product = ((*this)() >> 32) * bound;
+    }
+    return product >> 32;
+}
\ No newline at end of file
@@ -0,0 +1,581 @@
+#pragma once
+
+// Binary saved-game records, read and written on raw byte buffers
+// A record is a fixed 56-byte little-endian header followed by three bit planes (bomb, revealed, flagged),
+// each a run of 64-bit words with one bit per cell in border-free row-major order:
+//   0 magic "MSRC" | 4 version (u16) | 6 header size (u16) | 8 saved timestamp (i64) | 16 times played (i64)
+//   24 width (u32) | 28 height (u32) | 32 bombs (u32) | 36 revealed cells (u32) | 40 flagged cells (u32)
+//   44 checksum (u32) of the header without it and of the planes | 48 record id (u64, version 2 and up)
+// A seeded record stores a board the game generated itself as its generator seed instead of the bomb plane.
+// It has the same first 56 header bytes under the magic "MSRS", then:
+//   56 body size (u32) | 60 generator version (u16) | 62 options (u8: 1 safe opening, 2 first click made, 4 move log) | 63 zero
+//   body: 0 seed (u64) | 8 bombs digest (u64) | 16 first click (u32) | 20 roots count (u32)
+//         24 moves count (u32) | 28 move log size (u32) (version 2 and up, version 1 bodies start their varints at 24)
+//         then varint gaps between the sorted logical indices of the roots, then of the flagged cells,
+//         then the move log as kept by MinesweeperMoveLog, zero-padded to 4 bytes
+// Roots are the cells whose flood reveals, replayed on the regenerated board, open exactly the revealed cells,
+// so a saved game takes about a hundred bytes whatever the size of the field
+// A tombstone marks a record id as deleted in the records journal:
+//   0 magic "MSRD" | 4 version (u16) | 6 size (u16) | 8 record id (u64) | 16 checksum (u32) of bytes 0-15 | 20 zero (u32)
+// 3 bits per cell instead of one ASCII digit, and whole words are converted at a time on both ends
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MineField.h"
+
+using namespace std;
+
+struct MinesweeperRecordInfo {
+    uint64_t id; // record id
+
+    uint64_t offset; // offset of the record in the journal
+
+    uint32_t length; // size of the record in bytes, header included
+
+    int width, height, bombsCount;
+
+    long savedTimestamp, timesPlayed;
+};
+
+class MinesweeperRecord {
+    private:
+
+    static void putU16 (uint8_t* out, uint16_t value);
+
+    static void putU32 (uint8_t* out, uint32_t value);
+
+    static void putU64 (uint8_t* out, uint64_t value);
+
+    static uint16_t getU16 (const uint8_t* in);
+
+    static uint32_t getU32 (const uint8_t* in);
+
+    static uint64_t getU64 (const uint8_t* in);
+
+    static bool findRoots (const MineField &field, vector <uint32_t> &roots);
+    // list the sorted logical indices of the cells to flood from to open the revealed cells again
+    // false if the revealed cells aren't exactly what flood reveals would open
+
+    static void writeSeeded (const MineField &field, const vector <uint32_t> &roots, vector <uint8_t> &out);
+    // append the seeded record of field to out
+
+    static MineField* readSeeded (const uint8_t* header, size_t available, size_t &offset, string &error);
+    // read the seeded record at header, regenerating its bombs, see read
+
+    static int bitsCount (uint64_t bits);
+    // number of set bits of a word
+
+    static void checksumUpdate (uint64_t &low, uint64_t &high, const uint8_t* data, size_t size);
+    // feed size bytes (a multiple of 4) into a Fletcher-style running sum of 32-bit words
+
+    static uint32_t checksumFinish (uint64_t low, uint64_t high);
+    // fold the running sums into the stored checksum
+
+    public:
+
+    static const uint32_t MAGIC = 0x4352534D; // "MSRC" read as a little-endian word
+
+    static const uint32_t SEEDED_MAGIC = 0x5352534D; // "MSRS" read as a little-endian word
+
+    static const uint16_t SEEDED_VERSION = 2; // version 1 had no move log
+
+    static const int SEEDED_HEADER_SIZE = 64;
+
+    static const uint32_t TOMBSTONE_MAGIC = 0x4452534D; // "MSRD" read as a little-endian word
+
+    static const uint16_t VERSION = 2; // version 1 records had a 48-byte header without the record id
+
+    static const int HEADER_SIZE = 56;
+
+    static const int TOMBSTONE_SIZE = 24;
+
+    static size_t planeWords (int width, int height);
+    // number of 64-bit words in one bit plane
+
+    static size_t recordSize (int width, int height);
+    // number of bytes of a record of a <width x height> field
+
+    static void write (const MineField &field, vector <uint8_t> &out);
+    // append the record of field to out, a seeded record whenever the field can be regenerated from its seed
+
+    static MineField* read (const uint8_t* data, size_t size, size_t &offset, string &error);
+    // read the record starting at data[offset] and move offset past it
+    // returns nullptr and sets error if the record is truncated, of an unknown version, corrupted or not a playable field
+    // offset only moves past records that are intact but not playable, the others can't be skipped
+
+    static bool isRecord (const uint8_t* data, size_t size);
+    // check if a buffer starts with a binary record, to tell it from the legacy text format
+
+    static void writeTombstone (uint64_t id, vector <uint8_t> &out);
+    // append the tombstone of record id to out
+
+    static bool isTombstone (const uint8_t* data, size_t size);
+    // check if a buffer starts with a tombstone
+
+    static bool readTombstone (const uint8_t* data, size_t size, size_t &offset, uint64_t &id, string &error);
+    // read the tombstone starting at data[offset] into id and move offset past it, false and error if it is damaged
+
+    static const int PEEK_SIZE = 64; // bytes peek needs to see, shorter only at the end of a file
+
+    static bool peek (const uint8_t* data, size_t size, MinesweeperRecordInfo &info, bool &tombstone, string &error);
+    // describe the record or tombstone starting at data from its header alone, without reading (or checking) the planes
+    // size is the number of bytes available; info.length is set to the whole entry size, info.offset is left alone
+};
+
+void MinesweeperRecord::putU16 (uint8_t* out, uint16_t value) {
+    for (int i = 0; i < 2; ++i) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+void MinesweeperRecord::putU32 (uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+void MinesweeperRecord::putU64 (uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+uint16_t MinesweeperRecord::getU16 (const uint8_t* in) {
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+uint32_t MinesweeperRecord::getU32 (const uint8_t* in) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) value = (value << 8) | in[i];
+    return value;
+}
+
+uint64_t MinesweeperRecord::getU64 (const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) value = (value << 8) | in[i];
+    return value;
+}
+
+int MinesweeperRecord::bitsCount (uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(bits);
+#else
+    int count = 0;
+    for (; bits; bits &= bits - 1) ++count;
+    return count;
+#endif
+}
+
+void MinesweeperRecord::checksumUpdate (uint64_t &low, uint64_t &high, const uint8_t* data, size_t size) {
+    for (size_t i = 0; i + 4 <= size; i += 4) {
+        low += getU32(data + i);
+        high += low;
+    }
+}
+
+uint32_t MinesweeperRecord::checksumFinish (uint64_t low, uint64_t high) {
+    uint64_t folded = low ^ (high * 0x9E3779B97F4A7C15ull);
+    return (uint32_t)(folded ^ (folded >> 32));
+}
+
+size_t MinesweeperRecord::planeWords (int width, int height) {
+    return ((size_t)width * height + 63) / 64;
+}
+
+size_t MinesweeperRecord::recordSize (int width, int height) {
+    return HEADER_SIZE + 3 * 8 * planeWords(width, height);
+}
+
+bool MinesweeperRecord::isRecord (const uint8_t* data, size_t size) {
+    return size >= 4 && (getU32(data) == MAGIC || getU32(data) == SEEDED_MAGIC);
+}
+
+bool MinesweeperRecord::findRoots (const MineField &field, vector <uint32_t> &roots) {
+    // replay the flood reveals on a covered map: a revealed cell that no earlier root covers is a root
+    const DynamicBoard &board = field.board;
+    const array <int, 8> &offsets = board.neighborOffsets();
+    vector <uint8_t> covered(board.paddedSize(), 0);
+    vector <int> queue;
+    roots.clear();
+    uint32_t logical = 0;
+    for (int x = 0; x < field.Height; ++x) {
+        for (int y = 0; y < field.Width; ++y, ++logical) {
+            int index = board.index(x, y);
+            if (!MineCell::revealed(board[index]) || covered[index]) continue;
+            if (MineCell::hasBomb(board[index])) return false;
+            roots.push_back(logical);
+            covered[index] = 1;
+            queue.push_back(index);
+            while (!queue.empty()) {
+                int current = queue.back();
+                queue.pop_back();
+                if (MineCell::neighborBombsCount(board[current]) != 0) continue;
+                for (int offset : offsets) {
+                    int neighbor = current + offset;
+                    CellState cell = board[neighbor];
+                    if ((cell & MineCell::BORDER) || covered[neighbor]) continue;
+                    // the flood would open this cell, it has to be open already
+                    if (!MineCell::revealed(cell)) return false;
+                    covered[neighbor] = 1;
+                    queue.push_back(neighbor);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void MinesweeperRecord::write (const MineField &field, vector <uint8_t> &out) {
+    vector <uint32_t> roots;
+    if (field.seeded && findRoots(field, roots)) {
+        writeSeeded(field, roots, out);
+        return;
+    }
+    const DynamicBoard &board = field.board;
+    size_t words = planeWords(field.Width, field.Height);
+    size_t start = out.size();
+    out.resize(start + recordSize(field.Width, field.Height));
+    uint8_t* header = out.data() + start;
+    uint8_t* planes = header + HEADER_SIZE;
+    // gather the three planes a word at a time, walking the board row by row
+    uint64_t bomb = 0, revealed = 0, flagged = 0;
+    uint32_t revealedCount = 0, flaggedCount = 0;
+    size_t logical = 0;
+    for (int x = 0; x < field.Height; ++x) {
+        const CellState* row = board.data() + board.index(x, 0);
+        for (int y = 0; y < field.Width; ++y, ++logical) {
+            CellState cell = row[y];
+            uint64_t bit = (uint64_t)1 << (logical & 63);
+            if (MineCell::hasBomb(cell)) bomb |= bit;
+            if (MineCell::revealed(cell)) revealed |= bit;
+            if (MineCell::flagged(cell)) flagged |= bit;
+            if ((logical & 63) == 63) {
+                size_t word = logical >> 6;
+                putU64(planes + 8 * word, bomb);
+                putU64(planes + 8 * (words + word), revealed);
+                putU64(planes + 8 * (2 * words + word), flagged);
+                revealedCount += bitsCount(revealed);
+                flaggedCount += bitsCount(flagged);
+                bomb = revealed = flagged = 0;
+            }
+        }
+    }
+    if (logical & 63) {
+        size_t word = logical >> 6;
+        putU64(planes + 8 * word, bomb);
+        putU64(planes + 8 * (words + word), revealed);
+        putU64(planes + 8 * (2 * words + word), flagged);
+        revealedCount += bitsCount(revealed);
+        flaggedCount += bitsCount(flagged);
+    }
+    putU32(header, MAGIC);
+    putU16(header + 4, VERSION);
+    putU16(header + 6, HEADER_SIZE);
+    putU64(header + 48, field.recordId);
+    putU64(header + 8, (uint64_t)field.savedTimestamp);
+    putU64(header + 16, (uint64_t)field.timesPlayed);
+    putU32(header + 24, field.Width);
+    putU32(header + 28, field.Height);
+    putU32(header + 32, field.bombsCount);
+    putU32(header + 36, revealedCount);
+    putU32(header + 40, flaggedCount);
+    uint64_t low = 0, high = 0;
+    checksumUpdate(low, high, header, 44);
+    checksumUpdate(low, high, header + 48, HEADER_SIZE - 48);
+    checksumUpdate(low, high, planes, 3 * 8 * words);
+    putU32(header + 44, checksumFinish(low, high));
+}
+
+MineField* MinesweeperRecord::read (const uint8_t* data, size_t size, size_t &offset, string &error) {
+    const uint8_t* header = data + offset;
+    size_t available = size - offset;
+    if (available >= 4 && getU32(header) == SEEDED_MAGIC) return readSeeded(header, available, offset, error);
+    if (available < 48 || !isRecord(header, available)) {
+        error = "not a minesweeper record";
+        return nullptr;
+    }
+    int version = getU16(header + 4);
+    if (version < 1 || version > VERSION) {
+        error = "unsupported record version " + to_string(version);
+        return nullptr;
+    }
+    int headerSize = getU16(header + 6);
+    uint32_t width = getU32(header + 24), height = getU32(header + 28);
+    if (headerSize < (version == 1 ? 48 : HEADER_SIZE) || (size_t)headerSize > available || width == 0 || height == 0 || (uint64_t)width * height > INT32_MAX) {
+        error = "bad record header";
+        return nullptr;
+    }
+    size_t words = planeWords(width, height);
+    if (available - headerSize < 3 * 8 * words) {
+        error = "truncated record";
+        return nullptr;
+    }
+    const uint8_t* planes = header + headerSize;
+    uint64_t low = 0, high = 0;
+    checksumUpdate(low, high, header, 44);
+    checksumUpdate(low, high, header + 48, headerSize - 48);
+    checksumUpdate(low, high, planes, 3 * 8 * words);
+    if (checksumFinish(low, high) != getU32(header + 44)) {
+        error = "record checksum mismatch";
+        return nullptr;
+    }
+    offset += headerSize + 3 * 8 * words;
+    MineField* field = new MineField((long)getU64(header + 8), (long)getU64(header + 16), height, width);
+    // version 1 records have no id, the journal gives them one
+    field->recordId = version >= 2 ? getU64(header + 48) : 0;
+    // scatter the planes back a word at a time, walking the board row by row
+    DynamicBoard &board = field->board;
+    uint64_t bomb = 0, revealed = 0, flagged = 0;
+    size_t logical = 0;
+    for (uint32_t x = 0; x < height; ++x) {
+        CellState* row = board.data() + board.index(x, 0);
+        for (uint32_t y = 0; y < width; ++y, ++logical) {
+            int bit = logical & 63;
+            if (bit == 0) {
+                size_t word = logical >> 6;
+                bomb = getU64(planes + 8 * word);
+                revealed = getU64(planes + 8 * (words + word));
+                flagged = getU64(planes + 8 * (2 * words + word));
+            }
+            row[y] = (CellState)(((bomb >> bit) & 1) | (((revealed >> bit) & 1) << 1) | (((flagged >> bit) & 1) << 2));
+        }
+    }
+    if (!field->restore(getU32(header + 32)) || board.cellsCount() - field->unrevealedCellsCount != (int)getU32(header + 36) || field->bombsCount - field->flagsCount != (int)getU32(header + 40)) {
+        error = "record is not a playable field";
+        delete field;
+        return nullptr;
+    }
+    return field;
+}
+
+void MinesweeperRecord::writeSeeded (const MineField &field, const vector <uint32_t> &roots, vector <uint8_t> &out) {
+    size_t start = out.size();
+    out.resize(start + SEEDED_HEADER_SIZE + 32, 0);
+    for (size_t i = 0, previous = 0; i < roots.size(); previous = roots[i++]) MinesweeperMoveLog::putVarint(out, roots[i] - previous);
+    const DynamicBoard &board = field.board;
+    uint32_t revealedCount = board.cellsCount() - field.unrevealedCellsCount, flaggedCount = 0, logical = 0, previous = 0;
+    for (int x = 0; x < field.Height; ++x) {
+        const CellState* row = board.data() + board.index(x, 0);
+        for (int y = 0; y < field.Width; ++y, ++logical) {
+            if (!MineCell::flagged(row[y])) continue;
+            MinesweeperMoveLog::putVarint(out, logical - previous);
+            previous = logical;
+            ++flaggedCount;
+        }
+    }
+    const MinesweeperMoveLog &moves = field.moves;
+    if (moves.complete) out.insert(out.end(), moves.bytes.begin(), moves.bytes.end());
+    out.resize(start + (out.size() - start + 3) / 4 * 4, 0);
+    uint8_t* header = out.data() + start;
+    uint8_t* body = header + SEEDED_HEADER_SIZE;
+    putU32(header, SEEDED_MAGIC);
+    putU16(header + 4, SEEDED_VERSION);
+    putU16(header + 6, SEEDED_HEADER_SIZE);
+    putU64(header + 8, (uint64_t)field.savedTimestamp);
+    putU64(header + 16, (uint64_t)field.timesPlayed);
+    putU32(header + 24, field.Width);
+    putU32(header + 28, field.Height);
+    putU32(header + 32, field.bombsCount);
+    putU32(header + 36, revealedCount);
+    putU32(header + 40, flaggedCount);
+    putU64(header + 48, field.recordId);
+    putU32(header + 56, out.size() - start - SEEDED_HEADER_SIZE);
+    putU16(header + 60, MineField::GENERATOR_VERSION);
+    header[62] = (field.safeOpening ? 1 : 0) | (field.firstClick >= 0 ? 2 : 0) | (moves.complete ? 4 : 0);
+    putU64(body, field.seed);
+    putU64(body + 8, field.bombsDigest());
+    putU32(body + 16, field.firstClick >= 0 ? field.firstClick : 0);
+    putU32(body + 20, roots.size());
+    putU32(body + 24, moves.complete ? moves.count : 0);
+    putU32(body + 28, moves.complete ? moves.bytes.size() : 0);
+    uint64_t low = 0, high = 0;
+    checksumUpdate(low, high, header, 44);
+    checksumUpdate(low, high, header + 48, out.size() - start - 48);
+    putU32(header + 44, checksumFinish(low, high));
+}
+
+MineField* MinesweeperRecord::readSeeded (const uint8_t* header, size_t available, size_t &offset, string &error) {
+    // read only knows the magic is there, nothing past it may be read before the whole fixed header is
+    if (available < SEEDED_HEADER_SIZE) {
+        error = "truncated record";
+        return nullptr;
+    }
+    int version = getU16(header + 4), headerSize = getU16(header + 6);
+    if (version < 1 || version > SEEDED_VERSION) {
+        error = "unsupported seeded record version " + to_string(version);
+        return nullptr;
+    }
+    uint32_t width = getU32(header + 24), height = getU32(header + 28);
+    if (headerSize < SEEDED_HEADER_SIZE || (size_t)headerSize > available || width == 0 || height == 0 || (uint64_t)width * height > INT32_MAX) {
+        error = "bad record header";
+        return nullptr;
+    }
+    uint32_t bodySize = getU32(header + 56), bodyHeaderSize = version >= 2 ? 32 : 24;
+    if (bodySize < bodyHeaderSize || bodySize % 4 != 0 || available - headerSize < bodySize) {
+        error = "truncated record";
+        return nullptr;
+    }
+    uint64_t low = 0, high = 0;
+    checksumUpdate(low, high, header, 44);
+    checksumUpdate(low, high, header + 48, headerSize + bodySize - 48);
+    if (checksumFinish(low, high) != getU32(header + 44)) {
+        error = "record checksum mismatch";
+        return nullptr;
+    }
+    offset += headerSize + bodySize;
+    if (getU16(header + 60) != MineField::GENERATOR_VERSION) {
+        error = "bombs made by generator version " + to_string(getU16(header + 60)) + ", this game only regenerates version " + to_string(MineField::GENERATOR_VERSION);
+        return nullptr;
+    }
+    const uint8_t* body = header + headerSize;
+    uint32_t cellsCount = width * height, bombsCount = getU32(header + 32), firstClick = getU32(body + 16), rootsCount = getU32(body + 20);
+    bool clicked = header[62] & 2;
+    if (bombsCount == 0 || bombsCount >= cellsCount || (clicked && firstClick >= cellsCount)) {
+        error = "record is not a playable field";
+        return nullptr;
+    }
+    MineField* field = new MineField((long)getU64(header + 8), (long)getU64(header + 16), height, width);
+    field->recordId = getU64(header + 48);
+    field->seed = getU64(body);
+    field->safeOpening = header[62] & 1;
+    field->bombsCount = bombsCount;
+    DynamicBoard &board = field->board;
+    if (clicked) {
+        field->generateBombs(firstClick / width, firstClick % width);
+        if (field->bombsDigest() != getU64(body + 8)) {
+            error = "the regenerated bombs differ from the saved ones";
+            delete field;
+            return nullptr;
+        }
+    }
+    // flood from every root, then flag the listed cells
+    size_t cursor = bodyHeaderSize;
+    uint32_t logical = 0;
+    bool intact = true;
+    for (uint32_t i = 0; i < rootsCount && intact; ++i) {
+        uint32_t gap;
+        intact = MinesweeperMoveLog::getVarint(body, bodySize, cursor, gap) && (uint64_t)logical + gap < cellsCount && (i == 0 || gap > 0);
+        if (!intact) break;
+        logical += gap;
+        int index = board.paddedIndex(logical);
+        if (MineCell::hasBomb(board[index])) intact = false;
+        else if (!MineCell::revealed(board[index])) field->floodReveal(index);
+    }
+    logical = 0;
+    for (uint32_t i = 0, flagged = getU32(header + 40); i < flagged && intact; ++i) {
+        uint32_t gap;
+        intact = MinesweeperMoveLog::getVarint(body, bodySize, cursor, gap) && (uint64_t)logical + gap < cellsCount && (i == 0 || gap > 0);
+        if (!intact) break;
+        logical += gap;
+        CellState &cell = board[board.paddedIndex(logical)];
+        if (MineCell::revealed(cell)) intact = false;
+        cell |= MineCell::FLAGGED;
+    }
+    // the move log is kept as it is, each move is only checked to name a cell of the field
+    MinesweeperMoveLog moves;
+    bool logged = version >= 2 && (header[62] & 4);
+    if (logged && intact) {
+        uint32_t movesSize = getU32(body + 28);
+        intact = movesSize <= bodySize - cursor;
+        if (intact) moves.bytes.assign(body + cursor, body + cursor + movesSize);
+        MinesweeperMove move;
+        size_t position = 0;
+        while (intact && moves.count < getU32(body + 24)) {
+            intact = moves.next(position, move) && (uint32_t)move.cell < cellsCount;
+            ++moves.count;
+        }
+        intact = intact && position == movesSize;
+    }
+    uint32_t revealedCount = getU32(header + 36);
+    if (!intact || !field->restore(bombsCount) || board.cellsCount() - field->unrevealedCellsCount != (int)revealedCount || field->bombsCount - field->flagsCount != (int)getU32(header + 40) || clicked != (revealedCount > 0)) {
+        error = "record is not a playable field";
+        delete field;
+        return nullptr;
+    }
+    // restore draws a new seed for an untouched field, the bombs here came (or will come) from the stored one
+    field->seeded = true;
+    field->seed = getU64(body);
+    field->firstClick = clicked ? firstClick : -1;
+    if (logged) {
+        moves.complete = true;
+        field->moves = moves;
+    }
+    return field;
+}
+
+void MinesweeperRecord::writeTombstone (uint64_t id, vector <uint8_t> &out) {
+    size_t start = out.size();
+    out.resize(start + TOMBSTONE_SIZE, 0);
+    uint8_t* entry = out.data() + start;
+    putU32(entry, TOMBSTONE_MAGIC);
+    putU16(entry + 4, VERSION);
+    putU16(entry + 6, TOMBSTONE_SIZE);
+    putU64(entry + 8, id);
+    uint64_t low = 0, high = 0;
+    checksumUpdate(low, high, entry, 16);
+    putU32(entry + 16, checksumFinish(low, high));
+}
+
+bool MinesweeperRecord::isTombstone (const uint8_t* data, size_t size) {
+    return size >= 4 && getU32(data) == TOMBSTONE_MAGIC;
+}
+
+bool MinesweeperRecord::readTombstone (const uint8_t* data, size_t size, size_t &offset, uint64_t &id, string &error) {
+    const uint8_t* entry = data + offset;
+    size_t available = size - offset;
+    if (available < TOMBSTONE_SIZE || !isTombstone(entry, available) || getU16(entry + 6) < TOMBSTONE_SIZE || getU16(entry + 6) > available) {
+        error = "truncated tombstone";
+        return false;
+    }
+    uint64_t low = 0, high = 0;
+    checksumUpdate(low, high, entry, 16);
+    if (checksumFinish(low, high) != getU32(entry + 16)) {
+        error = "tombstone checksum mismatch";
+        return false;
+    }
+    id = getU64(entry + 8);
+    offset += getU16(entry + 6);
+    return true;
+}
+
+bool MinesweeperRecord::peek (const uint8_t* data, size_t size, MinesweeperRecordInfo &info, bool &tombstone, string &error) {
+    tombstone = isTombstone(data, size);
+    if (tombstone) {
+        if (size < TOMBSTONE_SIZE || getU16(data + 6) < TOMBSTONE_SIZE) {
+            error = "truncated tombstone";
+            return false;
+        }
+        info.id = getU64(data + 8);
+        info.length = getU16(data + 6);
+        return true;
+    }
+    if (size < 48 || !isRecord(data, size)) {
+        error = "not a minesweeper record";
+        return false;
+    }
+    if (getU32(data) == SEEDED_MAGIC) {
+        int headerSize = getU16(data + 6);
+        if (size < SEEDED_HEADER_SIZE || getU16(data + 4) < 1 || getU16(data + 4) > SEEDED_VERSION || headerSize < SEEDED_HEADER_SIZE || getU32(data + 24) == 0 || getU32(data + 28) == 0) {
+            error = "bad record header";
+            return false;
+        }
+        info.id = getU64(data + 48);
+        info.length = headerSize + getU32(data + 56);
+        info.width = getU32(data + 24);
+        info.height = getU32(data + 28);
+        info.bombsCount = getU32(data + 32);
+        info.savedTimestamp = (long)getU64(data + 8);
+        info.timesPlayed = (long)getU64(data + 16);
+        return true;
+    }
+    int version = getU16(data + 4), headerSize = getU16(data + 6);
+    uint32_t width = getU32(data + 24), height = getU32(data + 28);
+    if (version < 1 || version > VERSION || headerSize < (version == 1 ? 48 : HEADER_SIZE) || width == 0 || height == 0 || (uint64_t)width * height > INT32_MAX) {
+        error = "bad record header";
+        return false;
+    }
+    info.id = version >= 2 && size >= 56 ? getU64(data + 48) : 0;
+    info.length = headerSize + 3 * 8 * planeWords(width, height);
+    info.width = width;
+    info.height = height;
+    info.bombsCount = getU32(data + 32);
+    info.savedTimestamp = (long)getU64(data + 8);
+    info.timesPlayed = (long)getU64(data + 16);
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#pragma once
+
+// On-disk index of the records journal: the metadata of every live record, so the saved games can be listed
+// without reading a single board. The index remembers how much of the journal it covers; a longer journal is
+// caught up by peeking at the headers of the new entries only
+// File layout, little-endian: a 32-byte header then one 48-byte entry per live record, in id order
+//   header: 0 magic "MSRI" | 4 version (u16) | 6 entry size (u16) | 8 journal bytes covered (u64) | 16 next id (u64)
+//           24 entries count (u32) | 28 checksum (u32) of the header without it and of the entries
+//   entry:  0 id (u64) | 8 offset (u64) | 16 length (u32) | 20 width (u32) | 24 height (u32) | 28 bombs (u32)
+//           32 saved timestamp (i64) | 40 times played (i64)
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "MinesweeperFileSync.h"
+#include "MinesweeperRecord.h"
+
+using namespace std;
+
+class MinesweeperRecordIndex {
+    private:
+
+    static void putU32 (uint8_t* out, uint32_t value);
+
+    static void putU64 (uint8_t* out, uint64_t value);
+
+    static uint32_t getU32 (const uint8_t* in);
+
+    static uint64_t getU64 (const uint8_t* in);
+
+    static uint32_t checksum (const uint8_t* data, size_t size);
+    // checksum of the index file without its checksum field
+
+    public:
+
+    static const uint32_t MAGIC = 0x4952534D; // "MSRI" read as a little-endian word
+
+    static const uint16_t VERSION = 1;
+
+    static const int HEADER_SIZE = 32;
+
+    static const int ENTRY_SIZE = 48;
+
+    map <uint64_t, MinesweeperRecordInfo> entries; // live records by id, which is also the order they were first saved in
+
+    uint64_t journalBytes; // bytes of the journal described by entries
+
+    uint64_t nextId; // id for the next record saved for the first time
+
+    MinesweeperRecordIndex ();
+    // constructor, creates the index of an empty journal
+
+    void clear ();
+    // forget every entry
+
+    void apply (const MinesweeperRecordInfo &info, bool tombstone);
+    // account for a journal entry: a record replaces the previous version of its id, a tombstone drops it
+
+    size_t liveBytes () const;
+    // bytes of the journal taken by the last version of every live record
+
+    bool read (const string &path);
+    // load the index file, false if it is missing or damaged
+
+    bool write (const string &path) const;
+    // save the index file through a flushed temporary file and a rename
+};
+
+MinesweeperRecordIndex::MinesweeperRecordIndex () {
+    clear();
+}
+
+void MinesweeperRecordIndex::clear () {
+    entries.clear();
+    journalBytes = 0;
+    nextId = 1;
+}
+
+void MinesweeperRecordIndex::putU32 (uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+void MinesweeperRecordIndex::putU64 (uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+uint32_t MinesweeperRecordIndex::getU32 (const uint8_t* in) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) value = (value << 8) | in[i];
+    return value;
+}
+
+uint64_t MinesweeperRecordIndex::getU64 (const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) value = (value << 8) | in[i];
+    return value;
+}
+
+uint32_t MinesweeperRecordIndex::checksum (const uint8_t* data, size_t size) {
+    // FNV-1a over everything but the checksum field, the index is small
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        if (i >= 28 && i < 32) continue;
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+void MinesweeperRecordIndex::apply (const MinesweeperRecordInfo &info, bool tombstone) {
+    if (tombstone) entries.erase(info.id);
+    else entries[info.id] = info;
+    nextId = max(nextId, info.id + 1);
+}
+
+size_t MinesweeperRecordIndex::liveBytes () const {
+    size_t bytes = 0;
+    for (auto &entry : entries) bytes += entry.second.length;
+    return bytes;
+}
+
+bool MinesweeperRecordIndex::read (const string &path) {
+    clear();
+    ifstream file (path, ios::binary);
+    if (!file) return false;
+    vector <uint8_t> content( (istreambuf_iterator<char>(file) ), (istreambuf_iterator<char>()    ) );
+    if (content.size() < HEADER_SIZE || getU32(content.data()) != MAGIC || (content[4] | (content[5] << 8)) != VERSION || (content[6] | (content[7] << 8)) != ENTRY_SIZE) return false;
+    uint32_t count = getU32(content.data() + 24);
+    if (content.size() != HEADER_SIZE + (size_t)count * ENTRY_SIZE || checksum(content.data(), content.size()) != getU32(content.data() + 28)) return false;
+    journalBytes = getU64(content.data() + 8);
+    nextId = getU64(content.data() + 16);
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint8_t* entry = content.data() + HEADER_SIZE + (size_t)i * ENTRY_SIZE;
+        MinesweeperRecordInfo info;
+        info.id = getU64(entry);
+        info.offset = getU64(entry + 8);
+        info.length = getU32(entry + 16);
+        info.width = getU32(entry + 20);
+        info.height = getU32(entry + 24);
+        info.bombsCount = getU32(entry + 28);
+        info.savedTimestamp = (long)getU64(entry + 32);
+        info.timesPlayed = (long)getU64(entry + 40);
+        entries[info.id] = info;
+    }
+    return true;
+}
+
+bool MinesweeperRecordIndex::write (const string &path) const {
+    vector <uint8_t> content(HEADER_SIZE + entries.size() * ENTRY_SIZE, 0);
+    putU32(content.data(), MAGIC);
+    content[4] = VERSION & 0xFF;
+    content[5] = VERSION >> 8;
+    content[6] = ENTRY_SIZE & 0xFF;
+    content[7] = ENTRY_SIZE >> 8;
+    putU64(content.data() + 8, journalBytes);
+    putU64(content.data() + 16, nextId);
+    putU32(content.data() + 24, entries.size());
+    uint8_t* entry = content.data() + HEADER_SIZE;
+    for (auto &item : entries) {
+        const MinesweeperRecordInfo &info = item.second;
+        putU64(entry, info.id);
+        putU64(entry + 8, info.offset);
+        putU32(entry + 16, info.length);
+        putU32(entry + 20, info.width);
+        putU32(entry + 24, info.height);
+        putU32(entry + 28, info.bombsCount);
+        putU64(entry + 32, (uint64_t)info.savedTimestamp);
+        putU64(entry + 40, (uint64_t)info.timesPlayed);
+        entry += ENTRY_SIZE;
+    }
+    putU32(content.data() + 28, checksum(content.data(), content.size()));
+    string temporaryPath = path + ".tmp";
+    ofstream file (temporaryPath, ios::binary | ios::trunc);
+    file.write((const char*)content.data(), content.size());
+    file.close();
+    return file && MinesweeperFileSync::replace(temporaryPath, path);
+}
\ No newline at end of file
@@ -0,0 +1,221 @@
+#pragma once
+
+// Terminal renderer that remembers the frame on screen and only redraws the cells that changed
+// Boards larger than the terminal are shown through a viewport window that follows the moves and can be panned
+// Screen layout (1-based): top border on line 1, cell <x,y> at line 2 + 2(x - top), column 2 + 2(y - left),
+// status line right below the bottom border, then the viewport summary line when scrolling is possible, prompts after it
+
+#include <vector>
+
+#include "MineField.h"
+#include "MinesweeperFrame.h"
+#include "MinesweeperUtils.h"
+
+using namespace std;
+
+class MinesweeperRenderer {
+    private:
+
+    MinesweeperFrame frame;
+
+    MinesweeperUtils Utils;
+
+    vector <char> shown; // glyphs currently on screen, row-major over the shown window
+
+    const MineField* shownField; // field currently on screen, nullptr if the screen was cleared by someone else
+
+    int shownTop, shownLeft, shownRows, shownColumns; // window currently on screen
+
+    int viewTop, viewLeft, viewRows, viewColumns; // window to show on the next draw
+
+    int fieldHeight, fieldWidth; // size of the last drawn field
+
+    size_t totalBytes; // bytes written by all draws, for comparing output sizes
+
+    static const int RESERVED_LINES = 4; // status, viewport summary, prompt and its input echo
+
+    void moveCursor (int line, int column);
+    // append an ANSI cursor-positioning escape to the frame
+
+    int statusLine ();
+    // screen line of the status line of the shown window
+
+    void fitViewport (const MineField &field);
+    // size the viewport to the terminal and keep it inside the field
+
+    void renderSummary ();
+    // append the viewport summary: visible rows and columns, and a minimap bar for each axis
+
+    void appendMinimap (int start, int count, int total);
+    // append a bar where '=' marks the visible part of an axis of total cells
+
+    public:
+
+    MinesweeperRenderer ();
+
+    void invalidate ();
+    // forget the frame on screen, the next draw repaints everything
+
+    bool scrollable ();
+    // check if the last drawn field is larger than the viewport
+
+    bool pan (char direction);
+    // move the viewport by half a screen: w up, s down, a left, d right, returns false for other keys
+
+    void follow (int x, int y);
+    // recenter the viewport on <x,y> if that cell is out of view
+
+    size_t draw (const MineField &field);
+    // bring the screen up to date with field and park the cursor below it, returns the number of bytes written
+
+    size_t bytesWritten () const;
+    // total number of bytes written by all draws
+};
+
+MinesweeperRenderer::MinesweeperRenderer () {
+    viewTop = viewLeft = 0;
+    viewRows = viewColumns = 0;
+    fieldHeight = fieldWidth = 0;
+    totalBytes = 0;
+    invalidate();
+}
+
+void MinesweeperRenderer::invalidate () {
+    shownField = nullptr;
+    shownTop = shownLeft = shownRows = shownColumns = 0;
+}
+
+void MinesweeperRenderer::moveCursor (int line, int column) {
+    frame.append("\033[");
+    frame.appendInt(line);
+    frame.append(';');
+    frame.appendInt(column);
+    frame.append('H');
+}
+
+int MinesweeperRenderer::statusLine () {
+    return 2 * shownRows + 2;
+}
+
+bool MinesweeperRenderer::scrollable () {
+    return viewRows < fieldHeight || viewColumns < fieldWidth;
+}
+
+bool MinesweeperRenderer::pan (char direction) {
+    switch (direction) {
+        case 'w':
+            viewTop -= max(viewRows / 2, 1);
+            break;
+        case 's':
+            viewTop += max(viewRows / 2, 1);
+            break;
+        case 'a':
+            viewLeft -= max(viewColumns / 2, 1);
+            break;
+        case 'd':
+            viewLeft += max(viewColumns / 2, 1);
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+void MinesweeperRenderer::follow (int x, int y) {
+    if (x < viewTop || x >= viewTop + viewRows) viewTop = x - viewRows / 2;
+    if (y < viewLeft || y >= viewLeft + viewColumns) viewLeft = y - viewColumns / 2;
+}
+
+void MinesweeperRenderer::fitViewport (const MineField &field) {
+    int terminalRows, terminalColumns;
+    Utils.terminalSize(terminalRows, terminalColumns);
+    // r rows of cells take 2r + 1 lines with their borders, c columns take 2c + 1 characters
+    fieldHeight = field.Height;
+    fieldWidth = field.Width;
+    viewRows = max(1, min(field.Height, (terminalRows - RESERVED_LINES - 1) / 2));
+    viewColumns = max(1, min(field.Width, (terminalColumns - 1) / 2));
+    viewTop = max(0, min(viewTop, field.Height - viewRows));
+    viewLeft = max(0, min(viewLeft, field.Width - viewColumns));
+}
+
+void MinesweeperRenderer::appendMinimap (int start, int count, int total) {
+    const int barLength = 16;
+    frame.append('[');
+    for (int i = 0; i < barLength; ++i) {
+        // the part of the axis this character stands for, in cells
+        long from = (long)total * i / barLength, to = max((long)total * (i + 1) / barLength, from + 1);
+        frame.append(to > start && from < start + count ? '=' : '-');
+    }
+    frame.append(']');
+}
+
+void MinesweeperRenderer::renderSummary () {
+    frame.append("Rows ");
+    frame.appendInt(shownTop);
+    frame.append('-');
+    frame.appendInt(shownTop + shownRows - 1);
+    frame.append(' ');
+    appendMinimap(shownTop, shownRows, fieldHeight);
+    frame.append(" Columns ");
+    frame.appendInt(shownLeft);
+    frame.append('-');
+    frame.appendInt(shownLeft + shownColumns - 1);
+    frame.append(' ');
+    appendMinimap(shownLeft, shownColumns, fieldWidth);
+}
+
+size_t MinesweeperRenderer::draw (const MineField &field) {
+    frame.begin();
+    fitViewport(field);
+    const DynamicBoard &board = field.board;
+    bool full = shownField != &field || shownTop != viewTop || shownLeft != viewLeft || shownRows != viewRows || shownColumns != viewColumns;
+    if (full) {
+        // clear the screen with escapes, then paint the whole window from the top-left corner
+        frame.append("\033[2J\033[H");
+        field.render(frame, Utils.Colors, viewTop, viewLeft, viewRows, viewColumns);
+        shown.resize((size_t)viewRows * viewColumns);
+        for (int x = 0; x < viewRows; ++x) {
+            for (int y = 0; y < viewColumns; ++y) shown[(size_t)x * viewColumns + y] = MineCell::glyph(board[board.index(viewTop + x, viewLeft + y)]);
+        }
+        shownField = &field;
+        shownTop = viewTop;
+        shownLeft = viewLeft;
+        shownRows = viewRows;
+        shownColumns = viewColumns;
+        if (scrollable()) {
+            renderSummary();
+            frame.append('\n');
+        }
+        totalBytes += frame.size();
+        return frame.flush();
+    }
+    for (int x = 0; x < shownRows; ++x) {
+        const CellState* row = board.data() + board.index(shownTop + x, shownLeft);
+        char* shownRow = &shown[(size_t)x * shownColumns];
+        int lastWritten = -2;
+        for (int y = 0; y < shownColumns; ++y) {
+            char glyph = MineCell::glyph(row[y]);
+            if (glyph == shownRow[y]) continue;
+            // the cursor is already there after the previous cell, write over the separator instead of moving
+            if (y == lastWritten + 1) Utils.Colors.append(frame, '|', MinesweeperColors::DEFAULT);
+            else moveCursor(2 + 2 * x, 2 + 2 * y);
+            Utils.Colors.appendCell(frame, row[y]);
+            shownRow[y] = glyph;
+            lastWritten = y;
+        }
+    }
+    Utils.Colors.reset(frame);
+    // the status line is short, rewrite it whole
+    moveCursor(statusLine(), 1);
+    frame.append("\033[2K");
+    field.renderStatus(frame);
+    // wipe the previous prompts and leave the cursor where the next one goes
+    moveCursor(statusLine() + (scrollable() ? 2 : 1), 1);
+    frame.append("\033[J");
+    totalBytes += frame.size();
+    return frame.flush();
+}
+
+size_t MinesweeperRenderer::bytesWritten () const {
+    return totalBytes;
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+
+// Headless replay of saved games: the board is regenerated from the seed of the record, the move log is applied
+// through the same reveal and flag the game uses, and the outcome is compared with the saved field
+// Nothing is rendered, timed or logged again, and games of the same size reuse one field, so verifying archived games
+// costs the moves themselves
+
+#include <cstring>
+#include <string>
+
+#include "MineField.h"
+
+using namespace std;
+
+class MinesweeperReplay {
+    private:
+
+    MineField* field; // field rebuilt by the last replay, nullptr before the first one
+
+    public:
+
+    uint64_t movesReplayed; // moves applied by every replay so far
+
+    uint64_t gamesReplayed; // games replayed so far, matching or not
+
+    MinesweeperReplay ();
+    // constructor
+
+    ~MinesweeperReplay ();
+    // delete the last replayed field
+
+    MinesweeperReplay (const MinesweeperReplay&) = delete;
+
+    MinesweeperReplay& operator= (const MinesweeperReplay&) = delete;
+
+    bool replay (const MineField &saved, string &error);
+    // rebuild saved from its seed and move log, false and error if it has no full log or if the result differs
+
+    const MineField* result () const;
+    // field left by the last replay, the moves applied even when it didn't match
+};
+
+MinesweeperReplay::MinesweeperReplay () {
+    field = nullptr;
+    movesReplayed = 0;
+    gamesReplayed = 0;
+}
+
+MinesweeperReplay::~MinesweeperReplay () {
+    delete field;
+}
+
+const MineField* MinesweeperReplay::result () const {
+    return field;
+}
+
+bool MinesweeperReplay::replay (const MineField &saved, string &error) {
+    if (!saved.seeded || !saved.moves.complete) {
+        error = "the field has no complete move log from a seeded board";
+        return false;
+    }
+    // games of one size reuse the field, only its cells are cleared; another size needs a new board
+    if (field == nullptr || field->Height != saved.Height || field->Width != saved.Width) {
+        delete field;
+        field = new MineField(saved.Height, saved.Width, saved.bombsCount, saved.safeOpening);
+        field->logMoves = false;
+    }
+    field->bombsCount = saved.bombsCount;
+    field->safeOpening = saved.safeOpening;
+    field->reset(saved.seed);
+    ++gamesReplayed;
+    const MinesweeperMoveLog &moves = saved.moves;
+    MinesweeperMove move;
+    size_t cursor = 0;
+    for (uint32_t i = 0; i < moves.count; ++i) {
+        if (!moves.next(cursor, move) || move.cell >= field->board.cellsCount()) {
+            error = "damaged move log at move " + to_string(i);
+            return false;
+        }
+        field->reveal(move.cell / field->Width, move.cell % field->Width, false, move.flag);
+        ++movesReplayed;
+    }
+    // same size and same cells: the padded boards, neighbor counts included, are equal byte for byte
+    const vector <CellState> &expected = saved.board.cells, &actual = field->board.cells;
+    if (memcmp(expected.data(), actual.data(), expected.size()) != 0) {
+        int index = mismatch(expected.begin(), expected.end(), actual.begin()).first - expected.begin();
+        error = "cell (" + to_string(field->board.row(index)) + ", " + to_string(field->board.column(index)) + ") differs after " + to_string(moves.count) + " moves";
+        return false;
+    }
+    if (field->firstClick != saved.firstClick || field->unrevealedCellsCount != saved.unrevealedCellsCount || field->flagsCount != saved.flagsCount) {
+        error = "the counters differ after " + to_string(moves.count) + " moves";
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "MinesweeperReplay.h"
+#include "MinesweeperSimulation.h"
+#include "MinesweeperSolver.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+	// [--games N] [--seed S] [difficulty]: play N games with the solver and random guesses, logging their moves, then
+	// time MinesweeperReplay verifying all of them; exits with 1 if a game fails to verify
+	uint64_t games = 10000, seed = 1;
+	MinesweeperDifficulty difficulty {30, 16, 99};
+	bool valid = true;
+	for (int i = 1; i < argc && valid; ++i) {
+		if (i + 1 < argc && strcmp(argv[i], "--games") == 0) games = strtoull(argv[++i], nullptr, 10);
+		else if (i + 1 < argc && strcmp(argv[i], "--seed") == 0) seed = strtoull(argv[++i], nullptr, 10);
+		else valid = MinesweeperSimulation::parseDifficulty(argv[i], difficulty);
+	}
+	if (!valid || games == 0) {
+		cerr << "Usage: " << argv[0] << " [--games N] [--seed S] [beginner|intermediate|expert|<rows>x<columns>:<bombs>]" << endl;
+		return 2;
+	}
+	MineField field(difficulty.height, difficulty.width, difficulty.bombs);
+	MinesweeperSolver solver(field);
+	MinesweeperRandom random(seed);
+	MinesweeperSimulationStats stats;
+	stats.resize(difficulty.width * difficulty.height);
+	// the archive is the snapshots a save would write, boards and move logs
+	vector <MineField*> archive;
+	for (uint64_t game = 0; game < games; ++game) {
+		field.reset(random());
+		solver.reset();
+		MinesweeperSimulation::play(field, solver, nullptr, random, stats);
+		archive.push_back(field.snapshot());
+	}
+	MinesweeperReplay replay;
+	string error;
+	uint64_t failures = 0;
+	auto start = chrono::steady_clock::now();
+	for (MineField* saved : archive) failures += !replay.replay(*saved, error);
+	double seconds = chrono::duration <double>(chrono::steady_clock::now() - start).count();
+	cout << difficulty.height << "x" << difficulty.width << ", " << difficulty.bombs << " bombs: " << replay.gamesReplayed << " games | " << replay.movesReplayed << " moves | " << fixed << setprecision(3) << seconds << "s" << endl;
+	cout << setprecision(2) << replay.movesReplayed / seconds / 1e6 << "M moves/s | " << seconds * 1e6 / replay.gamesReplayed << " us/game | " << failures << " failed to verify" << endl;
+	if (failures > 0) cerr << "last failure: " << error << endl;
+	for (MineField* saved : archive) delete saved;
+	return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
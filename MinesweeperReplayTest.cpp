@@ -0,0 +1,72 @@
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "MinesweeperBatch.h"
+#include "MinesweeperCommandReader.h"
+#include "MinesweeperReplay.h"
+
+using namespace std;
+
+int main() {
+	// plays seeded games through the batch mode, saves them and verifies them from the field and from the journal,
+	// then checks that tampered fields fail to verify; exits with 1 if any check failed
+	const char* journalPath = "MinesweeperReplayTest.dat";
+	const char* indexPath = "MinesweeperReplayTest.idx";
+	remove(journalPath);
+	remove(indexPath);
+	int failures = 0;
+	auto check = [&](bool passed, const string &what) {
+		if (passed) return;
+		cerr << "FAIL: " << what << endl;
+		++failures;
+	};
+	// the moves come from a field generated from the same seed, so every game stays playable to the end of its commands
+	const uint64_t games = 20;
+	FILE* commands = tmpfile();
+	for (uint64_t game = 1; game <= games; ++game) {
+		MineField reference(16, 30, 99);
+		reference.seed = game * 0x9E3779B97F4A7C15ull;
+		fprintf(commands, "new 16 30 99 %llu\nreveal 8 15\n", (unsigned long long)reference.seed);
+		reference.reveal(8, 15, false, false);
+		int moves = 0, flags = 0;
+		for (int x = 0; x < reference.Height && moves < 12; ++x) {
+			for (int y = 0; y < reference.Width && moves < 12; ++y) {
+				CellState cell = reference.board[reference.cellIndex(x, y)];
+				if (MineCell::revealed(cell) || (MineCell::hasBomb(cell) && flags == 3)) continue;
+				bool flag = MineCell::hasBomb(cell);
+				flags += flag;
+				reference.reveal(x, y, false, flag);
+				fprintf(commands, "%s %d %d\n", flag ? "flag" : "reveal", x, y);
+				++moves;
+			}
+		}
+		fprintf(commands, "verify\nsave\nverify %llu\n", (unsigned long long)game);
+	}
+	rewind(commands);
+	{
+		MinesweeperCommandReader reader(commands, true);
+		MinesweeperBatch batch(false, journalPath);
+		batch.run(reader);
+		check(batch.errorsCount == 0, to_string(batch.errorsCount) + " batch commands failed");
+		check(batch.commandsCount > games * 5, "the batch stopped early");
+	}
+	// a field changed behind the move log, or without a complete one, must not verify
+	MinesweeperReplay replay;
+	string error;
+	MineField field(16, 30, 99);
+	field.reveal(8, 15, false, false);
+	check(replay.replay(field, error), "an untouched game failed to verify: " + error);
+	field.board[field.cellIndex(0, 0)] ^= MineCell::FLAGGED;
+	check(!replay.replay(field, error), "a flag missing from the move log verified");
+	field.board[field.cellIndex(0, 0)] ^= MineCell::FLAGGED;
+	field.seed ^= 1;
+	check(!replay.replay(field, error), "a game verified from another seed");
+	field.seed ^= 1;
+	field.reveal(0, 0, true, false);
+	check(!replay.replay(field, error), "a game without a complete move log verified");
+	remove(journalPath);
+	remove(indexPath);
+	cerr << (failures == 0 ? "all replay checks passed" : to_string(failures) + " replay checks failed") << endl;
+	return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,178 @@
+#pragma once
+
+// Background persistence of the saved games: the game thread only snapshots the field (its packed board, one byte per
+// cell, its metadata and its move log) and queues it, a worker thread encodes it and appends it to the journal
+// Requests are keyed by record id and only the latest one per id is kept, so saves of the same game coalesce
+// while the worker is busy, and a removal drops a save that hasn't been written yet
+// A request the journal fails to write (or flush) stays pending and is tried again after RETRY_DELAY, unless a newer
+// one for the same id replaced it; after MAX_ATTEMPTS it is dropped and reported through takeErrors
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "MineField.h"
+#include "MinesweeperJournal.h"
+
+using namespace std;
+
+class MinesweeperSaveWorker {
+    private:
+
+    MinesweeperJournal &journal; // where the records go
+
+    map <uint64_t, MineField*> pending; // record id -> snapshot to write, nullptr to remove the record
+
+    map <uint64_t, int> attempts; // record id -> failed writes of its pending request
+
+    vector <string> errors; // requests given up on, not taken yet
+
+    mutex pendingMutex; // guards pending, attempts, errors, busy and stopping
+
+    condition_variable wake; // signaled when work is queued or the worker has to stop
+
+    condition_variable idle; // signaled when the worker has written everything it took
+
+    bool busy; // the worker is writing a batch it took from pending
+
+    bool stopping; // the worker exits once pending is empty
+
+    thread worker;
+
+    void run ();
+    // worker loop: take every pending request, write them, compact the journal if needed, repeat
+
+    public:
+
+    static const int MAX_ATTEMPTS = 5; // writes of one request before it is given up
+
+    static constexpr chrono::milliseconds RETRY_DELAY {100}; // pause before failed requests are tried again
+
+    atomic <uint64_t> savesWritten; // snapshots written to the journal and flushed, coalesced saves only count once
+
+    MinesweeperSaveWorker (MinesweeperJournal &journal);
+    // constructor, starts the worker thread
+
+    ~MinesweeperSaveWorker ();
+    // write everything still pending and stop the worker
+
+    MinesweeperSaveWorker (const MinesweeperSaveWorker&) = delete;
+
+    MinesweeperSaveWorker& operator= (const MinesweeperSaveWorker&) = delete;
+
+    void save (MineField &field);
+    // queue a snapshot of field, giving it a record id first if it was never saved
+
+    void remove (uint64_t id);
+    // queue the removal of record id, dropping a save of it that is still pending
+
+    void flush ();
+    // block until every request queued so far is written or given up
+
+    vector <string> takeErrors ();
+    // why requests were given up since the last call, oldest first
+};
+
+MinesweeperSaveWorker::MinesweeperSaveWorker (MinesweeperJournal &journal) : journal(journal) {
+    busy = false;
+    stopping = false;
+    savesWritten = 0;
+    worker = thread(&MinesweeperSaveWorker::run, this);
+}
+
+MinesweeperSaveWorker::~MinesweeperSaveWorker () {
+    {
+        lock_guard <mutex> lock(pendingMutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void MinesweeperSaveWorker::save (MineField &field) {
+    // the id is given here, so the next save of the same game coalesces with this one and finds its record
+    if (field.recordId == 0) field.recordId = journal.reserveId();
+    MineField* snapshot = field.snapshot();
+    {
+        lock_guard <mutex> lock(pendingMutex);
+        MineField* &slot = pending[field.recordId];
+        delete slot;
+        slot = snapshot;
+        attempts.erase(field.recordId);
+    }
+    wake.notify_one();
+}
+
+void MinesweeperSaveWorker::remove (uint64_t id) {
+    if (id == 0) return;
+    {
+        lock_guard <mutex> lock(pendingMutex);
+        MineField* &slot = pending[id];
+        delete slot;
+        slot = nullptr;
+        attempts.erase(id);
+    }
+    wake.notify_one();
+}
+
+void MinesweeperSaveWorker::flush () {
+    unique_lock <mutex> lock(pendingMutex);
+    idle.wait(lock, [this] { return pending.empty() && !busy; });
+}
+
+vector <string> MinesweeperSaveWorker::takeErrors () {
+    lock_guard <mutex> lock(pendingMutex);
+    vector <string> taken;
+    taken.swap(errors);
+    return taken;
+}
+
+void MinesweeperSaveWorker::run () {
+    unique_lock <mutex> lock(pendingMutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (pending.empty()) break;
+        map <uint64_t, MineField*> batch;
+        batch.swap(pending);
+        busy = true;
+        lock.unlock();
+        map <uint64_t, MineField*> failed;
+        for (auto &request : batch) {
+            bool written = request.second == nullptr ? journal.remove(request.first) : journal.put(*request.second);
+            if (!written) {
+                failed.insert(request);
+                continue;
+            }
+            if (request.second != nullptr) ++savesWritten;
+            delete request.second;
+        }
+        journal.compactIfNeeded();
+        lock.lock();
+        for (auto &request : batch) {
+            if (!failed.count(request.first)) attempts.erase(request.first);
+        }
+        for (auto &request : failed) {
+            uint64_t id = request.first;
+            // a request queued meanwhile for the same record replaces the one that failed
+            if (pending.count(id)) delete request.second;
+            else if (++attempts[id] >= MAX_ATTEMPTS) {
+                errors.push_back(string(request.second == nullptr ? "removing" : "saving") + " record " + to_string(id) + " failed " + to_string(MAX_ATTEMPTS) + " times, it was given up");
+                attempts.erase(id);
+                delete request.second;
+            }
+            else pending[id] = request.second;
+        }
+        if (!failed.empty() && !pending.empty()) {
+            // a full disk or a flaky device doesn't recover at once, busy stays set so flush keeps waiting
+            lock.unlock();
+            this_thread::sleep_for(RETRY_DELAY);
+            lock.lock();
+        }
+        busy = false;
+        idle.notify_all();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MinesweeperSimulation.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+	// [--games N] [--threads T] [--seed S] [--probability] [--histograms] [difficulty...]
+	uint64_t games = 100000, seed = 1;
+	int threads = 0;
+	bool histograms = false, probabilityGuesses = false, valid = true;
+	vector <MinesweeperDifficulty> difficulties;
+	for (int i = 1; i < argc && valid; ++i) {
+		MinesweeperDifficulty difficulty;
+		if (strcmp(argv[i], "--histograms") == 0) histograms = true;
+		else if (strcmp(argv[i], "--probability") == 0) probabilityGuesses = true;
+		else if (i + 1 < argc && strcmp(argv[i], "--games") == 0) games = strtoull(argv[++i], nullptr, 10);
+		else if (i + 1 < argc && strcmp(argv[i], "--threads") == 0) threads = atoi(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "--seed") == 0) seed = strtoull(argv[++i], nullptr, 10);
+		else if (MinesweeperSimulation::parseDifficulty(argv[i], difficulty)) difficulties.push_back(difficulty);
+		else valid = false;
+	}
+	if (!valid || games == 0 || threads < 0) {
+		cerr << "Usage: " << argv[0] << " [--games N] [--threads T] [--seed S] [--probability] [--histograms] [beginner|intermediate|expert|<rows>x<columns>:<bombs>...]" << endl;
+		return 2;
+	}
+	if (difficulties.empty()) difficulties = {{9, 9, 10}, {16, 16, 40}, {30, 16, 99}};
+	MinesweeperSimulation simulation(difficulties, games, seed, threads);
+	simulation.probabilityGuesses = probabilityGuesses;
+	simulation.run();
+	simulation.print(cout, histograms);
+	return 0;
+}
\ No newline at end of file
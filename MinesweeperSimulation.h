@@ -0,0 +1,278 @@
+#pragma once
+
+// Monte Carlo statistics over many generated games per difficulty: win rate, 3BV and opening size distributions
+// Games are played by a simple player: the first click in the middle of the field, then every reveal MinesweeperSolver
+// proves safe, and a guess when nothing is proved: a uniform one among the cells the solver knows nothing about, or
+// the cell MinesweeperProbability finds least likely to be a mine
+// Games run in batches on a work-stealing pool; every worker owns its random engine, one reused field and solver per
+// difficulty and its own histograms, so a game allocates nothing and shares nothing, the histograms are merged at the end
+// Game g of difficulty d always starts from the same engine state, so results don't depend on the threads count
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "MineField.h"
+#include "MinesweeperLeaderboard.h"
+#include "MinesweeperProbability.h"
+#include "MinesweeperRandom.h"
+#include "MinesweeperSolver.h"
+#include "MinesweeperWorkPool.h"
+
+using namespace std;
+
+struct MinesweeperSimulationStats {
+    uint64_t games; // games played
+
+    uint64_t wins; // games won
+
+    uint64_t guesses; // moves no rule proved, the first click excluded
+
+    vector <uint64_t> threeBVCounts; // 3BV -> games
+
+    vector <uint64_t> openingCounts; // cells opened by the first click -> games
+
+    void resize (int cellsCount);
+    // zero every count, histograms hold values up to cellsCount
+
+    void merge (const MinesweeperSimulationStats &other);
+    // add the counts of other
+
+    static double mean (const vector <uint64_t> &counts);
+    // mean value of a histogram
+
+    static int percentile (const vector <uint64_t> &counts, double fraction);
+    // smallest value reached by at least fraction of the histogram
+};
+
+class MinesweeperSimulation {
+    private:
+
+    struct alignas(64) Worker {
+        MinesweeperRandom random {0}; // reseeded for every game
+
+        vector <MineField*> fields; // one reused field per difficulty
+
+        vector <MinesweeperSolver*> solvers; // one solver per field
+
+        vector <MinesweeperProbability*> probabilities; // one probability engine per field, when guesses use them
+
+        vector <MinesweeperSimulationStats> stats; // one histogram set per difficulty
+    };
+
+    public:
+
+    static const size_t BATCH_SIZE = 256; // games per pool task
+
+    vector <MinesweeperDifficulty> difficulties; // configurations to simulate
+
+    uint64_t gamesCount; // games per difficulty
+
+    uint64_t seed; // base seed of every game
+
+    int threadsCount; // workers, 0 for every hardware thread
+
+    bool probabilityGuesses; // guess the safest cell by exact probabilities instead of a uniform one
+
+    vector <MinesweeperSimulationStats> results; // merged statistics of the last run, one per difficulty
+
+    double seconds; // duration of the last run
+
+    uint64_t steals; // batches stolen by another worker during the last run
+
+    MinesweeperSimulation (const vector <MinesweeperDifficulty> &difficulties, uint64_t gamesCount, uint64_t seed, int threadsCount = 0);
+    // constructor
+
+    static bool parseDifficulty (const char* text, MinesweeperDifficulty &difficulty);
+    // read beginner, intermediate, expert or <rows>x<columns>:<bombs>, false if text is none of them
+
+    static bool guess (MineField &field, const MinesweeperSolver &solver, MinesweeperRandom &random);
+    // reveal a uniformly random hidden cell solver knows nothing about, `true` if it has a bomb
+
+    static bool play (MineField &field, MinesweeperSolver &solver, MinesweeperProbability* probability, MinesweeperRandom &random, MinesweeperSimulationStats &stats);
+    // play the untouched field to the end and count it in stats, returns `true` if it was won
+    // solver must follow field and have been reset since the field was; guesses are uniform if probability is nullptr
+
+    void run ();
+    // play gamesCount games of every difficulty on the pool and merge the statistics into results
+
+    void print (ostream &out, bool histograms) const;
+    // write a summary line per difficulty and the throughput, then every histogram bucket if histograms
+};
+
+void MinesweeperSimulationStats::resize (int cellsCount) {
+    games = wins = guesses = 0;
+    threeBVCounts.assign(cellsCount + 1, 0);
+    openingCounts.assign(cellsCount + 1, 0);
+}
+
+void MinesweeperSimulationStats::merge (const MinesweeperSimulationStats &other) {
+    games += other.games;
+    wins += other.wins;
+    guesses += other.guesses;
+    for (size_t i = 0; i < other.threeBVCounts.size(); ++i) threeBVCounts[i] += other.threeBVCounts[i];
+    for (size_t i = 0; i < other.openingCounts.size(); ++i) openingCounts[i] += other.openingCounts[i];
+}
+
+double MinesweeperSimulationStats::mean (const vector <uint64_t> &counts) {
+    double sum = 0, total = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        sum += (double)i * counts[i];
+        total += counts[i];
+    }
+    return total == 0 ? 0 : sum / total;
+}
+
+int MinesweeperSimulationStats::percentile (const vector <uint64_t> &counts, double fraction) {
+    uint64_t total = 0, seen = 0;
+    for (uint64_t count : counts) total += count;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen > 0 && seen >= fraction * total) return i;
+    }
+    return 0;
+}
+
+MinesweeperSimulation::MinesweeperSimulation (const vector <MinesweeperDifficulty> &difficulties, uint64_t gamesCount, uint64_t seed, int threadsCount) {
+    this->difficulties = difficulties;
+    this->gamesCount = gamesCount;
+    this->seed = seed;
+    this->threadsCount = threadsCount;
+    probabilityGuesses = false;
+    seconds = 0;
+    steals = 0;
+}
+
+bool MinesweeperSimulation::parseDifficulty (const char* text, MinesweeperDifficulty &difficulty) {
+    if (strcmp(text, "beginner") == 0) difficulty = {9, 9, 10};
+    else if (strcmp(text, "intermediate") == 0) difficulty = {16, 16, 40};
+    else if (strcmp(text, "expert") == 0) difficulty = {30, 16, 99};
+    else {
+        int rows, columns, bombs;
+        char end;
+        if (sscanf(text, "%dx%d:%d%c", &rows, &columns, &bombs, &end) != 3) return false;
+        difficulty = {columns, rows, bombs};
+    }
+    return difficulty.width > 0 && difficulty.height > 0 && difficulty.bombs > 0 && (long long)difficulty.width * difficulty.height <= 1 << 24 && difficulty.bombs < difficulty.width * difficulty.height;
+}
+
+bool MinesweeperSimulation::guess (MineField &field, const MinesweeperSolver &solver, MinesweeperRandom &random) {
+    DynamicBoard &board = field.board;
+    auto hidden = [&](int logical) { return solver.unknown(board.paddedIndex(logical)); };
+    int cellsCount = board.cellsCount(), target = -1;
+    // a few blind draws find a hidden cell while there are many, the count below is only needed near the end
+    for (int attempt = 0; attempt < 16 && target < 0; ++attempt) {
+        int logical = random.below(cellsCount);
+        if (hidden(logical)) target = logical;
+    }
+    if (target < 0) {
+        int count = 0;
+        for (int logical = 0; logical < cellsCount; ++logical) count += hidden(logical);
+        int pick = random.below(count);
+        for (target = 0; !hidden(target) || pick-- > 0; ++target);
+    }
+    return field.reveal(target / field.Width, target % field.Width, false, false);
+}
+
+bool MinesweeperSimulation::play (MineField &field, MinesweeperSolver &solver, MinesweeperProbability* probability, MinesweeperRandom &random, MinesweeperSimulationStats &stats) {
+    ++stats.games;
+    field.reveal(field.Height / 2, field.Width / 2, false, false);
+    ++stats.openingCounts[field.board.cellsCount() - field.unrevealedCellsCount];
+    ++stats.threeBVCounts[field.threeBV()];
+    while (field.unrevealedCellsCount > field.bombsCount) {
+        solver.solve();
+        // proved mines are left unflagged, only the reveals count towards the win
+        if (!solver.safeCells.empty()) {
+            for (int index : solver.safeCells) {
+                // a proved safe cell with a bomb is a solver bug, it loses the game instead of hiding in the win rate
+                bool hasBomb = field.reveal(field.board.row(index), field.board.column(index), false, false);
+#ifdef MINESWEEPER_DEBUG
+                assert(!hasBomb);
+#endif
+                if (hasBomb) return false;
+            }
+            continue;
+        }
+        ++stats.guesses;
+        int cell = probability != nullptr && probability->compute() ? probability->safestCell() : -1;
+        if (cell < 0 ? guess(field, solver, random) : field.reveal(field.board.row(cell), field.board.column(cell), false, false)) return false;
+    }
+    ++stats.wins;
+    return true;
+}
+
+void MinesweeperSimulation::run () {
+    MinesweeperWorkPool pool(threadsCount);
+    // the fields are built here, their constructor draws a seed from the shared engine
+    vector <Worker> workers(pool.threadsCount);
+    for (Worker &worker : workers) {
+        for (const MinesweeperDifficulty &difficulty : difficulties) {
+            worker.fields.push_back(new MineField(difficulty.height, difficulty.width, difficulty.bombs));
+            worker.fields.back()->logMoves = false;
+            worker.solvers.push_back(new MinesweeperSolver(*worker.fields.back()));
+            // the games already keep every core busy, a probability engine runs on its worker's thread
+            worker.probabilities.push_back(probabilityGuesses ? new MinesweeperProbability(*worker.fields.back(), 1) : nullptr);
+            worker.stats.emplace_back();
+            worker.stats.back().resize(difficulty.width * difficulty.height);
+        }
+    }
+    uint64_t batchesPerDifficulty = (gamesCount + BATCH_SIZE - 1) / BATCH_SIZE;
+    auto start = chrono::steady_clock::now();
+    pool.run(batchesPerDifficulty * difficulties.size(), [&](int w, size_t batch) {
+        Worker &worker = workers[w];
+        size_t d = batch / batchesPerDifficulty;
+        uint64_t first = (batch % batchesPerDifficulty) * BATCH_SIZE, end = min(first + BATCH_SIZE, gamesCount);
+        for (uint64_t game = first; game < end; ++game) {
+            worker.random.seed(seed + ((uint64_t)d << 40) + game);
+            worker.fields[d]->reset(worker.random());
+            worker.solvers[d]->reset();
+            play(*worker.fields[d], *worker.solvers[d], worker.probabilities[d], worker.random, worker.stats[d]);
+        }
+    });
+    seconds = chrono::duration <double>(chrono::steady_clock::now() - start).count();
+    steals = pool.steals;
+    results.clear();
+    for (size_t d = 0; d < difficulties.size(); ++d) {
+        results.push_back(workers[0].stats[d]);
+        for (size_t w = 1; w < workers.size(); ++w) results[d].merge(workers[w].stats[d]);
+    }
+    for (Worker &worker : workers) {
+        for (MinesweeperProbability* probability : worker.probabilities) delete probability;
+        for (MinesweeperSolver* solver : worker.solvers) delete solver;
+        for (MineField* field : worker.fields) delete field;
+    }
+    threadsCount = pool.threadsCount;
+}
+
+void MinesweeperSimulation::print (ostream &out, bool histograms) const {
+    uint64_t total = 0;
+    for (size_t d = 0; d < difficulties.size(); ++d) {
+        const MinesweeperDifficulty &difficulty = difficulties[d];
+        const MinesweeperSimulationStats &stats = results[d];
+        total += stats.games;
+        out << difficulty.height << "x" << difficulty.width << ", " << difficulty.bombs << " bombs: " << stats.games << " games"
+            << fixed << setprecision(2) << " | win " << 100.0 * stats.wins / max <uint64_t>(stats.games, 1) << "%"
+            << " | guesses/game " << (double)stats.guesses / max <uint64_t>(stats.games, 1)
+            << " | 3BV mean " << MinesweeperSimulationStats::mean(stats.threeBVCounts)
+            << " p10/p50/p90 " << MinesweeperSimulationStats::percentile(stats.threeBVCounts, 0.1) << "/" << MinesweeperSimulationStats::percentile(stats.threeBVCounts, 0.5) << "/" << MinesweeperSimulationStats::percentile(stats.threeBVCounts, 0.9)
+            << " | opening mean " << MinesweeperSimulationStats::mean(stats.openingCounts)
+            << " p10/p50/p90 " << MinesweeperSimulationStats::percentile(stats.openingCounts, 0.1) << "/" << MinesweeperSimulationStats::percentile(stats.openingCounts, 0.5) << "/" << MinesweeperSimulationStats::percentile(stats.openingCounts, 0.9) << endl;
+    }
+    out << total << " games in " << setprecision(3) << seconds << "s on " << threadsCount << " threads: " << setprecision(0) << total / max(seconds, 1e-9) << " games/s, " << steals << " batches stolen" << endl;
+    if (!histograms) return;
+    for (size_t d = 0; d < difficulties.size(); ++d) {
+        auto dump = [&](const char* name, const vector <uint64_t> &counts) {
+            for (size_t value = 0; value < counts.size(); ++value) {
+                if (counts[value] > 0) out << difficulties[d].height << "x" << difficulties[d].width << ":" << difficulties[d].bombs << " " << name << " " << value << " " << counts[value] << "\n";
+            }
+        };
+        dump("3bv", results[d].threeBVCounts);
+        dump("opening", results[d].openingCounts);
+    }
+    out << flush;
+}
\ No newline at end of file
@@ -0,0 +1,262 @@
+#pragma once
+
+// Deterministic solver following the visible state of a MineField: revealed numbers and flags, never the bombs
+// Every revealed number is a constraint "minesLeft mines among these unknown neighbors", kept as an 8-bit mask of
+// its neighbors; settling a cell (proving it safe or a mine) updates the masks of the numbers around it and queues them
+// A queued constraint is checked alone (no mine left: all safe, as many mines as cells: all mines) and against
+// every constraint whose neighbors can overlap its own (within 2 cells, on the board), bounding the mines of their common cells
+// covers the subset and superset rules and the overlapping ones (1-2 patterns)
+// The field appends the cells each reveal or flag changes to changedCells, so solve only touches the constraints
+// around them, never the whole board
+// Flags are taken as mines, like a chord does; only taking a flag back makes the solver read the whole field again,
+// since anything may have followed from it
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "MineField.h"
+
+using namespace std;
+
+class MinesweeperSolver {
+    private:
+
+    MineField &field; // field the solver follows
+
+    vector <uint8_t> knowledge; // board index -> what is known about the cell, a mix of the flags below
+
+    vector <uint8_t> unknownMask; // board index of a constraint -> bit k set if its neighbor k is still unknown
+
+    vector <int8_t> minesLeft; // board index of a constraint -> mines among its unknown neighbors
+
+    vector <int> dirty; // constraints to check again
+
+    uint64_t spread[256]; // neighbor mask -> the same cells in a 7x7 window centered on bit 24
+
+    int windowOffset[49]; // bit of a 7x7 window -> board index offset from its center
+
+    void settle (int index, bool mine);
+    // mark the unknown cell at index safe or a mine and update the constraints around it
+
+    void addConstraint (int index);
+    // start following the number just revealed at index
+
+    void settleWindow (int center, uint64_t cells, bool mine);
+    // settle the cells of a 7x7 window centered on board index center
+
+    bool check (int index);
+    // apply the rules to the constraint at index, `true` if it settled cells
+
+    void push (int index);
+    // queue the constraint at index if it isn't queued yet
+
+    static int bitsCount (uint64_t bits);
+    // number of set bits of a word
+
+    public:
+
+    static const uint8_t UNKNOWN = 0;
+
+    static const uint8_t SAFE = 1; // revealed or proved safe
+
+    static const uint8_t MINE = 2; // flagged or proved a mine
+
+    static const uint8_t FLAG_ONLY = 4; // a mine only because of a flag
+
+    static const uint8_t CONSTRAINT = 8; // a revealed number the solver follows
+
+    static const uint8_t QUEUED = 16; // the constraint is in dirty
+
+    vector <int> safeCells; // board indices proved safe and still hidden, the forced reveals
+
+    vector <int> mineCells; // board indices proved mines and not flagged yet, the forced flags
+
+    uint64_t checks; // constraints checked since the last reset
+
+    MinesweeperSolver (MineField &field);
+    // constructor, follows field from its current state and turns its change log on
+
+    void reset ();
+    // forget everything and read the whole visible field again, O(board); needed after the field is reset or restored
+
+    void solve ();
+    // apply the changes of the field since the last call and propagate until nothing more follows
+    // safeCells and mineCells then hold every forced move
+
+    bool unknown (int index) const;
+    // check if nothing is known about the cell at board index
+};
+
+MinesweeperSolver::MinesweeperSolver (MineField &field) : field(field) {
+    // bits 0..7 of a mask are the 3x3 cells around the center in row-major order, like the neighbor offsets
+    for (int mask = 0; mask < 256; ++mask) {
+        spread[mask] = 0;
+        for (int k = 0, bit = 0; k < 9; ++k) {
+            if (k == 4) continue;
+            if (mask & (1 << bit)) spread[mask] |= (uint64_t)1 << ((k / 3 + 2) * 7 + k % 3 + 2);
+            ++bit;
+        }
+    }
+    reset();
+}
+
+void MinesweeperSolver::reset () {
+    DynamicBoard &board = field.board;
+    field.logChanges = true;
+    field.changedCells.clear();
+    for (int bit = 0; bit < 49; ++bit) windowOffset[bit] = (bit / 7 - 3) * board.stride() + bit % 7 - 3;
+    knowledge.assign(board.paddedSize(), (uint8_t)SAFE);
+    unknownMask.assign(board.paddedSize(), 0);
+    minesLeft.assign(board.paddedSize(), 0);
+    dirty.clear();
+    safeCells.clear();
+    mineCells.clear();
+    checks = 0;
+    for (int x = 0; x < field.Height; ++x) {
+        for (int index = board.index(x, 0), end = index + field.Width; index < end; ++index) {
+            CellState cell = board[index];
+            knowledge[index] = MineCell::revealed(cell) ? SAFE : MineCell::flagged(cell) ? MINE | FLAG_ONLY : UNKNOWN;
+        }
+    }
+    for (int x = 0; x < field.Height; ++x) {
+        for (int index = board.index(x, 0), end = index + field.Width; index < end; ++index) {
+            if (MineCell::revealed(board[index])) addConstraint(index);
+        }
+    }
+    solve();
+}
+
+int MinesweeperSolver::bitsCount (uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(bits);
+#else
+    int count = 0;
+    for (; bits; bits &= bits - 1) ++count;
+    return count;
+#endif
+}
+
+bool MinesweeperSolver::unknown (int index) const {
+    return (knowledge[index] & (SAFE | MINE)) == 0;
+}
+
+void MinesweeperSolver::push (int index) {
+    if (knowledge[index] & QUEUED) return;
+    knowledge[index] |= QUEUED;
+    dirty.push_back(index);
+}
+
+void MinesweeperSolver::settle (int index, bool mine) {
+    knowledge[index] |= mine ? MINE : SAFE;
+    const array <int, 8> &offsets = field.board.neighborOffsets();
+    // offsets k and 7 - k are opposite, so the cell is the neighbor 7 - k of its neighbor k
+    for (int k = 0; k < 8; ++k) {
+        int neighbor = index + offsets[k];
+        if (!(knowledge[neighbor] & CONSTRAINT)) continue;
+        unknownMask[neighbor] &= ~(1 << (7 - k));
+        minesLeft[neighbor] -= mine;
+        push(neighbor);
+    }
+}
+
+void MinesweeperSolver::addConstraint (int index) {
+    CellState cell = field.board[index];
+    // a revealed bomb ends the game, and a 0 has its neighbors revealed with it
+    if ((knowledge[index] & CONSTRAINT) || MineCell::hasBomb(cell) || MineCell::neighborBombsCount(cell) == 0) return;
+    const array <int, 8> &offsets = field.board.neighborOffsets();
+    int mask = 0, mines = MineCell::neighborBombsCount(cell);
+    for (int k = 0; k < 8; ++k) {
+        uint8_t neighbor = knowledge[index + offsets[k]];
+        if (neighbor & MINE) --mines;
+        else if (!(neighbor & SAFE)) mask |= 1 << k;
+    }
+    knowledge[index] |= CONSTRAINT;
+    unknownMask[index] = mask;
+    minesLeft[index] = mines;
+    push(index);
+}
+
+void MinesweeperSolver::settleWindow (int center, uint64_t cells, bool mine) {
+    while (cells) {
+        int index = center + windowOffset[MineBoardBase <DynamicBoard>::lowestBit(cells)];
+        cells &= cells - 1;
+        if (!unknown(index)) continue;
+        settle(index, mine);
+        (mine ? mineCells : safeCells).push_back(index);
+    }
+}
+
+bool MinesweeperSolver::check (int index) {
+    ++checks;
+    int mask = unknownMask[index], mines = minesLeft[index], count = bitsCount(mask);
+    // a wrong flag can make a number impossible, nothing sound follows from it
+    if (count == 0 || mines < 0 || mines > count) return false;
+    if (mines == 0 || mines == count) {
+        settleWindow(index, spread[mask], mines != 0);
+        return true;
+    }
+    int stride = field.board.stride(), x = field.board.row(index), y = field.board.column(index);
+    uint64_t own = spread[mask];
+    // the padding ring is one cell wide, the window is clipped to the board so it never reads past the vectors
+    for (int dx = max(-2, -x); dx <= min(2, field.Height - 1 - x); ++dx) {
+        for (int dy = max(-2, -y); dy <= min(2, field.Width - 1 - y); ++dy) {
+            int other = index + dx * stride + dy;
+            if ((dx == 0 && dy == 0) || !(knowledge[other] & CONSTRAINT) || unknownMask[other] == 0) continue;
+            int shift = dx * 7 + dy;
+            uint64_t theirs = shift >= 0 ? spread[unknownMask[other]] << shift : spread[unknownMask[other]] >> -shift;
+            uint64_t common = own & theirs;
+            if (common == 0) continue;
+            uint64_t onlyOwn = own & ~theirs, onlyTheirs = theirs & ~own;
+            int otherMines = minesLeft[other], ownCount = bitsCount(onlyOwn), theirCount = bitsCount(onlyTheirs);
+            // bounds of the mines among the common cells, from both constraints
+            int low = max({0, mines - ownCount, otherMines - theirCount}), high = min({bitsCount(common), mines, otherMines});
+            if (low > high) continue;
+            bool settled = false;
+            if (onlyOwn && mines - low == 0) settleWindow(index, onlyOwn, false), settled = true;
+            else if (onlyOwn && mines - high == ownCount) settleWindow(index, onlyOwn, true), settled = true;
+            if (onlyTheirs && otherMines - low == 0) settleWindow(index, onlyTheirs, false), settled = true;
+            else if (onlyTheirs && otherMines - high == theirCount) settleWindow(index, onlyTheirs, true), settled = true;
+            // this constraint was queued again by what it settled, its mask is stale now
+            if (settled) return true;
+        }
+    }
+    return false;
+}
+
+void MinesweeperSolver::solve () {
+    DynamicBoard &board = field.board;
+    // the forced moves lists are only filtered when one of their cells was played
+    bool safePlayed = false, minePlayed = false;
+    for (size_t i = 0; i < field.changedCells.size(); ++i) {
+        int index = field.changedCells[i];
+        CellState cell = board[index];
+        if ((knowledge[index] & FLAG_ONLY) && !MineCell::flagged(cell)) {
+            // a flag taken back (or opened by a flood) may have led to anything, everything is read again
+            reset();
+            return;
+        }
+        if (MineCell::revealed(cell)) {
+            safePlayed |= (knowledge[index] & SAFE) != 0;
+            minePlayed |= (knowledge[index] & MINE) != 0;
+            if (unknown(index)) settle(index, false);
+            addConstraint(index);
+        }
+        else if (MineCell::flagged(cell) && unknown(index)) {
+            settle(index, true);
+            knowledge[index] |= FLAG_ONLY;
+        }
+        else minePlayed |= (knowledge[index] & MINE) != 0;
+    }
+    field.changedCells.clear();
+    while (!dirty.empty()) {
+        int index = dirty.back();
+        dirty.pop_back();
+        knowledge[index] &= ~QUEUED;
+        check(index);
+    }
+    // forced moves the player already made are dropped
+    auto played = [&](int index) { return MineCell::revealed(board[index]); };
+    if (safePlayed) safeCells.erase(remove_if(safeCells.begin(), safeCells.end(), played), safeCells.end());
+    if (minePlayed) mineCells.erase(remove_if(mineCells.begin(), mineCells.end(), [&](int index) { return MineCell::flagged(board[index]) || played(index); }), mineCells.end());
+}
\ No newline at end of file
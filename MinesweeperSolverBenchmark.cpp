@@ -0,0 +1,98 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "MinesweeperProbability.h"
+#include "MinesweeperSimulation.h"
+#include "MinesweeperSolver.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+	// [--games N] [--seed S] [--probability] [--threads T] [difficulty]: time MinesweeperSolver::solve after every single
+	// move of generated games, and MinesweeperProbability::compute before every guess with --probability
+	uint64_t games = 10000, seed = 1;
+	MinesweeperDifficulty difficulty {30, 16, 99};
+	int threads = 0;
+	bool probabilityGuesses = false, valid = true;
+	for (int i = 1; i < argc && valid; ++i) {
+		if (strcmp(argv[i], "--probability") == 0) probabilityGuesses = true;
+		else if (i + 1 < argc && strcmp(argv[i], "--games") == 0) games = strtoull(argv[++i], nullptr, 10);
+		else if (i + 1 < argc && strcmp(argv[i], "--seed") == 0) seed = strtoull(argv[++i], nullptr, 10);
+		else if (i + 1 < argc && strcmp(argv[i], "--threads") == 0) threads = atoi(argv[++i]);
+		else valid = MinesweeperSimulation::parseDifficulty(argv[i], difficulty);
+	}
+	if (!valid || games == 0 || threads < 0) {
+		cerr << "Usage: " << argv[0] << " [--games N] [--seed S] [--probability] [--threads T] [beginner|intermediate|expert|<rows>x<columns>:<bombs>]" << endl;
+		return 2;
+	}
+	MineField field(difficulty.height, difficulty.width, difficulty.bombs);
+	field.logMoves = false;
+	MinesweeperSolver solver(field);
+	MinesweeperProbability probability(field, threads);
+	MinesweeperRandom random(seed);
+	// latencies in 10 ns buckets, the last one holds everything from 100 us up
+	vector <uint64_t> latencies(10001, 0);
+	uint64_t moves = 0, wins = 0, checks = 0, longest = 0;
+	double total = 0;
+	auto timedSolve = [&]() {
+		auto start = chrono::steady_clock::now();
+		solver.solve();
+		uint64_t nanoseconds = chrono::duration_cast <chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+		++latencies[min <uint64_t>(nanoseconds / 10, latencies.size() - 1)];
+		longest = max(longest, nanoseconds);
+		total += nanoseconds;
+		++moves;
+	};
+	// compute durations in 10 us buckets up to 1 s, all frontiers and those of 60 cells or more
+	vector <uint64_t> computes(100001, 0), largeComputes(100001, 0);
+	uint64_t approximated = 0;
+	int largestFrontier = 0;
+	double slowest = 0, computeTotal = 0, largeTotal = 0;
+	auto timedCompute = [&]() {
+		probability.compute();
+		size_t bucket = min <size_t>(probability.milliseconds * 100, computes.size() - 1);
+		++computes[bucket];
+		computeTotal += probability.milliseconds;
+		if (probability.frontierCells >= 60) {
+			++largeComputes[bucket];
+			largeTotal += probability.milliseconds;
+		}
+		slowest = max(slowest, probability.milliseconds);
+		largestFrontier = max(largestFrontier, probability.frontierCells);
+		approximated += probability.approximatedComponents > 0;
+		return probability.safestCell();
+	};
+	for (uint64_t game = 0; game < games; ++game) {
+		field.reset(random());
+		solver.reset();
+		field.reveal(field.Height / 2, field.Width / 2, false, false);
+		timedSolve();
+		bool lost = false;
+		while (!lost && field.unrevealedCellsCount > field.bombsCount) {
+			// one move at a time, each followed by the solve it triggers
+			int cell = !solver.safeCells.empty() ? solver.safeCells.back() : probabilityGuesses ? timedCompute() : -1;
+			if (cell >= 0) lost = field.reveal(field.board.row(cell), field.board.column(cell), false, false);
+			else lost = MinesweeperSimulation::guess(field, solver, random);
+			timedSolve();
+		}
+		wins += !lost;
+		checks += solver.checks;
+	}
+	auto percentile = [&](double fraction) { return MinesweeperSimulationStats::percentile(latencies, fraction) * 0.01; };
+	cout << difficulty.height << "x" << difficulty.width << ", " << difficulty.bombs << " bombs: " << games << " games, " << wins << " won, " << moves << " moves, " << fixed << setprecision(1) << (double)checks / moves << " constraint checks/move" << endl;
+	cout << "solve per move: mean " << setprecision(3) << total / moves / 1000 << " us | p50 " << percentile(0.5) << " us | p99 " << percentile(0.99) << " us | p99.9 " << percentile(0.999) << " us | max " << longest / 1000.0 << " us" << endl;
+	if (!probabilityGuesses) return 0;
+	auto report = [&](const char* name, const vector <uint64_t> &durations, double sum) {
+		uint64_t count = 0;
+		for (uint64_t bucket : durations) count += bucket;
+		cout << "probabilities, " << name << ": " << count << " computes | mean " << setprecision(3) << sum / max <uint64_t>(count, 1) << " ms | p50 " << MinesweeperSimulationStats::percentile(durations, 0.5) * 0.01 << " ms | p99 " << MinesweeperSimulationStats::percentile(durations, 0.99) * 0.01 << " ms" << endl;
+	};
+	report("all frontiers", computes, computeTotal);
+	report("frontiers of 60+ cells", largeComputes, largeTotal);
+	cout << "largest frontier " << largestFrontier << " cells | slowest " << slowest << " ms | " << approximated << " computes approximated" << endl;
+	return 0;
+}
\ No newline at end of file
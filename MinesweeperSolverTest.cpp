@@ -0,0 +1,46 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MinesweeperSimulation.h"
+#include "MinesweeperSolver.h"
+
+using namespace std;
+
+int main() {
+	// plays games on boards that are mostly edge rows and columns and checks every deduction of the solver against the
+	// bombs; build it with -fsanitize=address as well, the window around a constraint on an edge row once read past the
+	// solver's vectors; exits with 1 if any check failed
+	vector <MinesweeperDifficulty> difficulties {{30, 1, 5}, {30, 2, 10}, {30, 3, 15}, {2, 30, 10}, {3, 30, 15}, {4, 4, 3}, {5, 3, 4}, {30, 16, 99}};
+	MinesweeperRandom random(1);
+	uint64_t games = 0, deductions = 0, failures = 0;
+	for (const MinesweeperDifficulty &difficulty : difficulties) {
+		MineField field(difficulty.height, difficulty.width, difficulty.bombs);
+		field.logMoves = false;
+		MinesweeperSolver solver(field);
+		for (int game = 0; game < 2000; ++game, ++games) {
+			field.reset(random());
+			solver.reset();
+			bool lost = field.reveal(field.Height / 2, field.Width / 2, false, false);
+			while (!lost && field.unrevealedCellsCount > field.bombsCount) {
+				solver.solve();
+				for (int index : solver.mineCells) {
+					++deductions;
+					if (!MineCell::hasBomb(field.board[index])) ++failures;
+				}
+				if (solver.safeCells.empty()) {
+					lost = MinesweeperSimulation::guess(field, solver, random);
+					continue;
+				}
+				vector <int> safeCells = solver.safeCells;
+				for (int index : safeCells) {
+					++deductions;
+					if (MineCell::hasBomb(field.board[index])) ++failures;
+					lost |= field.reveal(field.board.row(index), field.board.column(index), false, false);
+				}
+			}
+		}
+	}
+	cerr << games << " games, " << deductions << " deductions, " << failures << " unsound" << endl;
+	return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
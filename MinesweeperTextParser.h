@@ -0,0 +1,160 @@
+#pragma once
+
+// Single-pass parser for the legacy text records file, kept to migrate old saves to the binary format
+// Records are separated by a blank line, each one is:
+//   saved timestamp \n times played \n rows [columns] \n one digit (flagged*4 + revealed*2 + hasBomb) per cell
+// The parser walks a string_view with one cursor and never copies the text; errors carry their line, column and offset
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+
+#include "MineField.h"
+
+using namespace std;
+
+class MinesweeperTextParser {
+    private:
+
+    string_view text; // whole file contents, owned by the caller
+
+    size_t position; // cursor into text
+
+    int line; // 1-based line of the cursor
+
+    size_t lineStart; // offset of the first character of the current line
+
+    string lastError; // description of the last failure
+
+    MineField* fail (const string &message);
+    // record message with the cursor location, returns nullptr
+
+    void skipSpaces ();
+    // skip spaces, tabs and carriage returns on the current line
+
+    bool readNumber (long &number);
+    // read a non-negative decimal number
+
+    bool endLine ();
+    // consume the end of the current line (or of the text), false if something else is there
+
+    public:
+
+    MinesweeperTextParser (string_view text);
+    // constructor, starts at the beginning of text
+
+    bool atEnd ();
+    // skip blank lines, then check if there is no record left
+
+    MineField* readRecord ();
+    // parse the record at the cursor, returns nullptr and sets error() if it is malformed or not a playable field
+
+    void skipRecord ();
+    // move the cursor past the blank line ending the current record, to resume after a malformed one
+
+    const string& error () const;
+    // description of the last failure, with its location
+};
+
+MinesweeperTextParser::MinesweeperTextParser (string_view text) {
+    this->text = text;
+    position = 0;
+    line = 1;
+    lineStart = 0;
+}
+
+MineField* MinesweeperTextParser::fail (const string &message) {
+    lastError = "line " + to_string(line) + ", column " + to_string(position - lineStart + 1) + " (offset " + to_string(position) + "): " + message;
+    return nullptr;
+}
+
+const string& MinesweeperTextParser::error () const {
+    return lastError;
+}
+
+void MinesweeperTextParser::skipSpaces () {
+    while (position < text.size() && (text[position] == ' ' || text[position] == '\t' || text[position] == '\r')) ++position;
+}
+
+bool MinesweeperTextParser::readNumber (long &number) {
+    skipSpaces();
+    size_t start = position;
+    number = 0;
+    while (position < text.size() && text[position] >= '0' && text[position] <= '9' && position - start < 18) {
+        number = number * 10 + (text[position] - '0');
+        ++position;
+    }
+    return position > start;
+}
+
+bool MinesweeperTextParser::endLine () {
+    skipSpaces();
+    if (position == text.size()) return true;
+    if (text[position] != '\n') return false;
+    ++position;
+    ++line;
+    lineStart = position;
+    return true;
+}
+
+bool MinesweeperTextParser::atEnd () {
+    while (true) {
+        skipSpaces();
+        if (position == text.size()) return true;
+        if (text[position] != '\n') return false;
+        endLine();
+    }
+}
+
+void MinesweeperTextParser::skipRecord () {
+    // start from the line break before the cursor line, in case the cursor already sits on the blank line
+    size_t end = text.find("\n\n", lineStart > 0 ? lineStart - 1 : 0);
+    end = end == string_view::npos ? text.size() : end + 2;
+    int lines = count(text.begin() + position, text.begin() + end, '\n');
+    if (lines > 0) {
+        line += lines;
+        lineStart = text.rfind('\n', end - 1) + 1;
+    }
+    position = end;
+}
+
+MineField* MinesweeperTextParser::readRecord () {
+    long timestamp, timesPlayed, rows, columns;
+    if (!readNumber(timestamp)) return fail("expected the saved timestamp");
+    if (!endLine()) return fail("unexpected text after the saved timestamp");
+    if (!readNumber(timesPlayed)) return fail("expected the times played");
+    if (!endLine()) return fail("unexpected text after the times played");
+    // the size line is "rows" for square fields, "rows columns" otherwise
+    if (!readNumber(rows)) return fail("expected the field size");
+    skipSpaces();
+    if (position < text.size() && text[position] != '\n') {
+        if (!readNumber(columns)) return fail("expected the number of columns");
+    }
+    else columns = rows;
+    if (!endLine()) return fail("unexpected text after the field size");
+    if (rows == 0 || columns == 0) return fail("empty field");
+    if (rows * columns > INT32_MAX) return fail("field too large");
+    MineField* field = new MineField(timestamp, timesPlayed, rows, columns);
+    DynamicBoard &board = field->board;
+    for (int x = 0; x < rows; ++x) {
+        CellState* row = board.data() + board.index(x, 0);
+        for (int y = 0; y < columns; ++y, ++position) {
+            char digit = position < text.size() ? text[position] : '\n';
+            if (digit < '0' || digit > '7') {
+                delete field;
+                if (digit == '\n' || digit == '\r') return fail("board data ends after " + to_string((long)x * columns + y) + " of " + to_string(rows * columns) + " cells");
+                return fail(string("unexpected character '") + digit + "' in board data");
+            }
+            row[y] = (CellState)(digit - '0');
+        }
+    }
+    if (!endLine()) {
+        delete field;
+        return fail("board data longer than " + to_string(rows * columns) + " cells");
+    }
+    if (!field->restore()) {
+        delete field;
+        return fail("record is not a playable field");
+    }
+    return field;
+}
\ No newline at end of file
@@ -1,10 +1,23 @@
+#pragma once
+
 #include <iostream>
 #include <future>
+#include <functional>
+#include <thread>
+#include <vector>
 #include <random>
 #include <ctime>
 #include <sstream>
+#include <string_view>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
 
 #include "MinesweeperColors.h"
+#include "MinesweeperRandom.h"
 
 using namespace std;
 
@@ -23,6 +36,9 @@ class MinesweeperUtils {
     void clearInterval(atomic_bool& controller);
     // clear the specified Interval
 
+    MinesweeperRandom& randomEngine ();
+    // the shared random engine, seeded once from random_device
+
     int randInt (int range);
     // random an integer from range 0 -> range
 
@@ -32,10 +48,16 @@ class MinesweeperUtils {
     void readInt(int& num);
     // Safe way to read an int to the console and assign it to a var, returns -1 if failed; 
 
+    bool isInt (const string& str);
+    // check if str is a (possibly negative) decimal integer
+
+    void terminalSize (int& rows, int& columns);
+    // get the console size in characters, 24x80 if it can't be detected
+
     void pauseConsole(bool includeMessage);
     // pause console - with or without prompting message
 
-    vector <string> splitString(string str, string splitter);
+    vector <string> splitString(string_view str, string_view splitter);
     // split the string with given splitter
 
     int stoi(string str);
@@ -48,8 +70,9 @@ class MinesweeperUtils {
     // convert seconds to AhBmCs
 };
 
-void MinesweeperUtils::clearConsole () {        
-    if (system("CLS")) system("clear");
+void MinesweeperUtils::clearConsole () {
+    // ANSI: clear the screen and the scrollback, then home the cursor, no shell process involved
+    cout << "\033[2J\033[3J\033[H" << flush;
 };
 
 template <class F, class... Args>
@@ -68,16 +91,21 @@ void MinesweeperUtils::clearInterval(atomic_bool& controller) {
     controller.store(false);
 }
 
-int MinesweeperUtils::randIntInRange (int start, int end) {
+MinesweeperRandom& MinesweeperUtils::randomEngine () {
     // https://stackoverflow.com/questions/43432014/c-generate-random-number-every-time/43432296#43432296
     static random_device rd;
-    static mt19937 gen(rd());
+    static MinesweeperRandom gen(((uint64_t)rd() << 32) | rd());
+    return gen;
+}
+
+int MinesweeperUtils::randIntInRange (int start, int end) {
     uniform_int_distribution<> dis(start, end);
-    return dis(gen);
+    return dis(randomEngine());
 }
 
 int MinesweeperUtils::randInt (int range) {
-    return randIntInRange(0, range);
+    if (range <= 0) return 0;
+    return randomEngine().below((uint32_t)range + 1);
 }
 
 void MinesweeperUtils::readInt(int& num) {
@@ -96,19 +124,45 @@ void MinesweeperUtils::readInt(int& num) {
     }
 }
 
+bool MinesweeperUtils::isInt (const string& str) {
+    size_t start = (str.size() > 1 && str[0] == '-') ? 1 : 0;
+    if (start == str.size()) return false;
+    for (size_t i = start; i < str.size(); ++i) {
+        if (str[i] < '0' || str[i] > '9') return false;
+    }
+    return true;
+}
+
+void MinesweeperUtils::terminalSize (int& rows, int& columns) {
+    rows = 24;
+    columns = 80;
+#ifndef _WIN32
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0 && size.ws_col > 0) {
+        rows = size.ws_row;
+        columns = size.ws_col;
+        return;
+    }
+#endif
+    // not a terminal (or no ioctl), fall back to what the shell exported
+    if (getenv("LINES")) rows = max(atoi(getenv("LINES")), 1);
+    if (getenv("COLUMNS")) columns = max(atoi(getenv("COLUMNS")), 1);
+}
+
 void MinesweeperUtils::pauseConsole (bool includeMessage) {
     if (includeMessage) cout << endl << "Press any key to continue...";
     int prom = getchar();
 };
 
-vector <string> MinesweeperUtils::splitString (string str, string splitter) {
+vector <string> MinesweeperUtils::splitString (string_view str, string_view splitter) {
+    // one cursor over the input, every character is looked at once
     vector <string> result;
-    size_t found;
-    while ((found = str.find(splitter)) != string::npos) {
-        result.push_back(str.substr(0, found));
-        str = str.substr((int)found + splitter.length(), str.length());
+    size_t start = 0, found;
+    while ((found = str.find(splitter, start)) != string_view::npos) {
+        result.emplace_back(str.substr(start, found - start));
+        start = found + splitter.length();
     }
-    if (str.length() != 0) result.push_back(str);
+    if (start < str.length()) result.emplace_back(str.substr(start));
     return result;
 }
 
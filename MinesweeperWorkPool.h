@@ -0,0 +1,98 @@
+#pragma once
+
+// Work-stealing pool for a fixed batch of independent tasks: tasks 0..count-1 are dealt in contiguous runs to one
+// queue per worker, a worker takes its own tasks from the front and, once its queue is empty, steals from the back
+// of the others, so uneven tasks still keep every core busy until the whole batch is done
+// Each queue has its own lock, workers only meet on a lock when one of them steals
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class MinesweeperWorkPool {
+    private:
+
+    struct WorkQueue {
+        mutex lock; // guards tasks
+
+        deque <size_t> tasks; // tasks left, the owner takes the front and thieves the back
+    };
+
+    vector <unique_ptr <WorkQueue>> queues; // one queue per worker
+
+    bool take (int worker, size_t &task);
+    // next task of worker: its own first, then one stolen from the others, false once every queue is empty
+
+    public:
+
+    int threadsCount; // workers, the calling thread included
+
+    uint64_t steals; // tasks run by another worker than the one they were dealt to, during the last run
+
+    MinesweeperWorkPool (int threadsCount = 0);
+    // constructor, 0 uses every hardware thread
+
+    void run (size_t tasksCount, const function <void(int worker, size_t task)> &work);
+    // call work for every task on threadsCount threads, the calling thread being worker 0, and return once all are done
+};
+
+MinesweeperWorkPool::MinesweeperWorkPool (int threadsCount) {
+    this->threadsCount = threadsCount > 0 ? threadsCount : max <int>(thread::hardware_concurrency(), 1);
+    steals = 0;
+}
+
+bool MinesweeperWorkPool::take (int worker, size_t &task) {
+    {
+        WorkQueue &own = *queues[worker];
+        lock_guard <mutex> lock(own.lock);
+        if (!own.tasks.empty()) {
+            task = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    // no task is ever added during a run, so one empty sweep over the others means the batch is finished
+    for (int i = 1; i < threadsCount; ++i) {
+        WorkQueue &victim = *queues[(worker + i) % threadsCount];
+        lock_guard <mutex> lock(victim.lock);
+        if (victim.tasks.empty()) continue;
+        task = victim.tasks.back();
+        victim.tasks.pop_back();
+        return true;
+    }
+    return false;
+}
+
+void MinesweeperWorkPool::run (size_t tasksCount, const function <void(int worker, size_t task)> &work) {
+    queues.clear();
+    for (int i = 0; i < threadsCount; ++i) {
+        queues.push_back(make_unique <WorkQueue>());
+        // contiguous runs, so a worker that never steals keeps its tasks in order
+        for (size_t task = tasksCount * i / threadsCount; task < tasksCount * (i + 1) / threadsCount; ++task) queues[i]->tasks.push_back(task);
+    }
+    vector <uint64_t> stolen(threadsCount, 0);
+    auto loop = [&](int worker) {
+        size_t task, first = tasksCount * worker / threadsCount, end = tasksCount * (worker + 1) / threadsCount;
+        // counted locally, neighboring slots of stolen would share a cache line
+        uint64_t count = 0;
+        while (take(worker, task)) {
+            count += task < first || task >= end;
+            work(worker, task);
+        }
+        stolen[worker] = count;
+    };
+    vector <thread> threads;
+    for (int i = 1; i < threadsCount; ++i) threads.emplace_back(loop, i);
+    loop(0);
+    for (thread &worker : threads) worker.join();
+    steals = 0;
+    for (uint64_t count : stolen) steals += count;
+}
\ No newline at end of file